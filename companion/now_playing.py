@@ -2,7 +2,7 @@
 Holocubic Now Playing Companion
 
 Windows 上執行，透過 Windows Media Session (SMTC) 偵測正在播放的音樂，
-在 PC 端預渲染捲動動畫幀，上傳到 ESP32 SD 卡播放。
+在 PC 端渲染專輯封面與標題/歌手文字條，上傳到 ESP32 SD 卡，由裝置逐像素捲動。
 
 適用於所有 Windows 媒體來源：YouTube Music (瀏覽器)、Spotify、VLC 等。
 
@@ -18,6 +18,7 @@ import argparse
 import asyncio
 import io
 import os
+import struct
 import sys
 import time
 
@@ -36,8 +37,14 @@ CANVAS_SIZE = 128
 ART_HEIGHT = 100
 TEXT_BAR_HEIGHT = CANVAS_SIZE - ART_HEIGHT
 
-SCROLL_PX_PER_FRAME = 10
-SCROLL_PAUSE_FRAMES = 15
+TEXT_LEFT = 4
+CLIP_X = 3
+CLIP_W = CANVAS_SIZE - 2 * CLIP_X
+STRIP_MAX_BYTES = 16384  # NP_STRIP_MAX_BYTES on the device
+STRIP_MAGIC = 0x534E  # "NS"
+
+TITLE_COLOR = (255, 255, 255)
+ARTIST_COLOR = (0, 210, 255)
 
 TITLE_FONT_SIZE = 10
 ARTIST_FONT_SIZE = 8
@@ -74,16 +81,8 @@ TITLE_FONT = _find_font(TITLE_FONT_SIZE)
 ARTIST_FONT = _find_font(ARTIST_FONT_SIZE)
 
 
-def _text_width(text, font):
-    bbox = font.getbbox(text)
-    return bbox[2] - bbox[0]
-
-
-def _render_frames(art_img, title, artist):
-    """Render all animation frames as list of BMP bytes."""
-    frames = []
-
-    # Prepare art
+def _render_scene(art_img, title, artist):
+    """Render the art with an empty text bar (BMP bytes) and one strip per text line."""
     if art_img:
         art_img.thumbnail((CANVAS_SIZE, CANVAS_SIZE), Image.LANCZOS)
         if art_img.size != (CANVAS_SIZE, CANVAS_SIZE):
@@ -95,61 +94,34 @@ def _render_frames(art_img, title, artist):
     else:
         art_img = Image.new("RGB", (CANVAS_SIZE, CANVAS_SIZE), (20, 20, 30))
 
-    # Measure text
-    title_w = _text_width(title, TITLE_FONT)
-    artist_w = _text_width(artist, ARTIST_FONT)
-    max_visible = CANVAS_SIZE - 8
-
-    # Determine scroll ranges
-    title_scroll = max(0, title_w - max_visible)
-    artist_scroll = max(0, artist_w - max_visible)
-    max_scroll = max(title_scroll, artist_scroll)
-
-    if max_scroll == 0:
-        # Static — single frame
-        frame = _compose_frame(art_img, title, artist, 0, 0)
-        frames.append(_to_bmp(frame))
-    else:
-        # Pause at start
-        frame0 = _compose_frame(art_img, title, artist, 0, 0)
-        bmp0 = _to_bmp(frame0)
-        frames.append(bmp0)
-
-        # Scroll
-        total_scroll_steps = max_scroll // SCROLL_PX_PER_FRAME
-        for step in range(1, total_scroll_steps + 1):
-            px = step * SCROLL_PX_PER_FRAME
-            t_off = min(px, title_scroll)
-            a_off = min(px, artist_scroll)
-            frame = _compose_frame(art_img, title, artist, t_off, a_off)
-            frames.append(_to_bmp(frame))
-
-        # Pause at end
-        frame_end = _compose_frame(art_img, title, artist, title_scroll, artist_scroll)
-        bmp_end = _to_bmp(frame_end)
-        frames.append(bmp_end)
-
-    return frames
+    img = art_img.copy()
+    bar = img.crop((0, ART_HEIGHT, CANVAS_SIZE, CANVAS_SIZE))
+    img.paste(bar.point(lambda p: p // 3), (0, ART_HEIGHT))
 
+    strips = {
+        "title": _render_strip(title, TITLE_FONT, ART_HEIGHT + 2, TITLE_COLOR),
+        "artist": _render_strip(artist, ARTIST_FONT, ART_HEIGHT + 16, ARTIST_COLOR),
+    }
+    return _to_bmp(img), strips
 
-def _compose_frame(art_img, title, artist, title_offset, artist_offset):
-    img = art_img.copy()
 
-    bar_y = ART_HEIGHT
-    bar = img.crop((0, bar_y, CANVAS_SIZE, CANVAS_SIZE))
-    bar = bar.point(lambda p: p // 3)
-    img.paste(bar, (0, bar_y))
+def _render_strip(text, font, y, color):
+    """Text coverage as an 8-bit alpha strip; the device blends it over the bar."""
+    if not text:
+        return None
 
-    draw = ImageDraw.Draw(img)
-    draw.text((4 - title_offset, bar_y + 2), title, font=TITLE_FONT, fill=(255, 255, 255))
-    draw.text((4 - artist_offset, bar_y + 16), artist, font=ARTIST_FONT, fill=(0, 210, 255))
+    bbox = font.getbbox(text)
+    w = max(1, bbox[2])
+    h = max(1, bbox[3])
+    w = min(w, STRIP_MAX_BYTES // h)
 
-    left_mask = art_img.crop((0, bar_y, 3, CANVAS_SIZE)).point(lambda p: p // 3)
-    right_mask = art_img.crop((CANVAS_SIZE - 3, bar_y, CANVAS_SIZE, CANVAS_SIZE)).point(lambda p: p // 3)
-    img.paste(left_mask, (0, bar_y))
-    img.paste(right_mask, (CANVAS_SIZE - 3, bar_y))
+    strip = Image.new("L", (w, h), 0)
+    ImageDraw.Draw(strip).text((0, 0), text, font=font, fill=255)
 
-    return img
+    r, g, b = color
+    color565 = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3)
+    header = struct.pack("<HhhHHHhh", STRIP_MAGIC, TEXT_LEFT, y, w, h, color565, CLIP_X, CLIP_W)
+    return header + strip.tobytes()
 
 
 def _to_bmp(img):
@@ -164,7 +136,7 @@ class NowPlayingCompanion:
         self._interval = interval
         self._last_key = ""
         self._running = True
-        self._pending_frames = None
+        self._pending_scene = None
         self._uploaded = False
 
     async def run(self):
@@ -213,22 +185,17 @@ class NowPlayingCompanion:
                 except Exception:
                     art_img = None
 
-            frames = _render_frames(art_img, title, artist)
-            print(f"    Rendered {len(frames)} frames")
-
-            self._pending_title = title
-            self._pending_artist = artist
-            self._pending_frames = frames
+            self._pending_scene = _render_scene(art_img, title, artist)
             self._uploaded = False
 
-            ok = self._push_metadata(title, artist, len(frames))
+            ok = self._push_metadata(title, artist)
             if not ok:
                 self._last_key = ""
 
-        if self._pending_frames and not self._uploaded:
+        if self._pending_scene and not self._uploaded:
             if self._is_now_playing_active():
-                print("    NowPlaying active, uploading frames...")
-                ok = self._upload_frames(self._pending_frames)
+                print("    NowPlaying active, uploading scene...")
+                ok = self._upload_scene(*self._pending_scene)
                 if ok:
                     print("    Uploaded OK")
                     self._uploaded = True
@@ -252,14 +219,13 @@ class NowPlayingCompanion:
         except Exception:
             return None
 
-    def _push_metadata(self, title, artist, frame_count):
+    def _push_metadata(self, title, artist):
         try:
             r = requests.post(
                 f"http://{self._ip}/api/now-playing",
                 json={
                     "title": title,
                     "artist": artist,
-                    "frameCount": frame_count,
                 },
                 timeout=HTTP_TIMEOUT,
             )
@@ -287,27 +253,34 @@ class NowPlayingCompanion:
             pass
         return False
 
-    def _upload_frames(self, frames):
+    @staticmethod
+    def _post_file(url, name, data, mime):
+        for attempt in range(3):
+            try:
+                r = requests.post(
+                    url,
+                    files={"file": (name, data, mime)},
+                    timeout=FRAME_UPLOAD_TIMEOUT,
+                )
+                if r.ok:
+                    return True
+                print(f"    {name} attempt {attempt+1} failed: {r.status_code}")
+            except requests.RequestException as e:
+                print(f"    {name} attempt {attempt+1} error: {e}")
+            time.sleep(0.5)
+        print(f"    {name} upload failed after 3 attempts")
+        return False
+
+    def _upload_scene(self, art_bmp, strips):
         base = f"http://{self._ip}"
 
-        for i, bmp in enumerate(frames):
-            ok = False
-            for attempt in range(3):
-                try:
-                    r = requests.post(
-                        f"{base}/api/np/frame/{i}",
-                        files={"file": (f"{i}.bmp", bmp, "image/bmp")},
-                        timeout=FRAME_UPLOAD_TIMEOUT,
-                    )
-                    if r.ok:
-                        ok = True
-                        break
-                    print(f"    Frame {i} attempt {attempt+1} failed: {r.status_code}")
-                except requests.RequestException as e:
-                    print(f"    Frame {i} attempt {attempt+1} error: {e}")
-                time.sleep(0.5)
-            if not ok:
-                print(f"    Frame {i} upload failed after 3 attempts")
+        # Frame 0 first: it clears the previous track's files
+        if not self._post_file(f"{base}/api/np/frame/0", "0.bmp", art_bmp, "image/bmp"):
+            return False
+        for name, data in strips.items():
+            if data and not self._post_file(
+                f"{base}/api/np/strip/{name}", f"{name}.bin", data, "application/octet-stream"
+            ):
                 return False
 
         try:
@@ -5,6 +5,7 @@
 
 // WiFi
 #define WIFI_CONFIG_FILE "/wifi.json"
+#define PLAYBACK_CONFIG_FILE "/playback.json"
 #define AP_SSID "Holocubic"
 #define AP_PASSWORD "12345678"
 #define WIFI_CONNECT_TIMEOUT 15
@@ -28,6 +29,7 @@
 
 // MPU6050
 #define MPU_ADDR 0x68
+#define MPU_CALIBRATION_SAMPLES 300 // taken 2 ms apart while the device is still
 #define REG_PWR_MGMT_1 0x6B
 #define REG_ACCEL_XOUT 0x3B
 
@@ -39,9 +41,16 @@
 #define CANVAS_X 0
 #define CANVAS_Y 16
 
-// Overlay
-#define OVERLAY_HEIGHT 16
-#define OVERLAY_SHOW_MS 2500
+// Status strip: the panel rows above and below the canvas
+#define STATUS_HEIGHT CANVAS_Y
+#define STATUS_BOTTOM_Y (CANVAS_Y + CANVAS_HEIGHT)
+#define STATUS_POLL_MS 1000 // how often wifi and the clock are checked
+
+// Boot
+#define FAST_BOOT 1 // play the last GIF first; WiFi, MPU calibration and library rebuilds finish in the background. 0 = blocking boot with the IP screen
+#define BOOT_PHASE_MAX 12 // boot timeline entries kept for /api/stats
+#define CURSOR_NVS_NAMESPACE "holocubic" // NVS namespace for the last-played GIF
+#define CURSOR_SAVE_DELAY_MS 5000 // a GIF has to stay on this long before it becomes the boot cursor
 
 // NTP
 #define NTP_SERVER "pool.ntp.org"
@@ -55,22 +64,52 @@
 
 // SD Card Paths
 #define GIFS_ROOT "/gifs"
-#define ORDER_FILE "/gifs/order.json"
-#define GIF_CONFIG_FILE "config.json"
+#define LIBRARY_FILE "/gifs/library.bin" // binary index: playback order and every GIF's metadata
+#define LIBRARY_TMP_FILE "/gifs/library.tmp" // written in full, then renamed over LIBRARY_FILE
+#define LIBRARY_SAVE_DELAY_MS 2000 // library changes within this window share one write
+#define ORDER_FILE "/gifs/order.json"    // legacy order, only read when rebuilding the index
+#define GIF_CONFIG_FILE "config.json"    // per-GIF copy of its record, for rebuilding the index
+#define GIF_PACK_FILE "frames.bin"
+#define GIF_ORIGINAL_FILE "original.gif"
 
 // Performance
 #define SPI_FREQUENCY 40000000
 #define SD_SPI_FREQUENCY 20000000
 #define I2C_FREQUENCY 400000
+#define LOADER_STATS_FRAMES 200 // log decode throughput every N frames, 0 = off
+#define RENDER_STATS_FRAMES 200 // log panel push timing every N frames, 0 = off
+#define RENDER_ASYNC 1 // push the front canvas from a core 0 task instead of blocking core 1
+#define CANVAS_BIG_ENDIAN 1 // canvases hold RGB565 in panel byte order, so pushes need no swap
+#define DISPLAY_BUFFERS 3 // drawing + queued + on the wire; 2 makes swapAndRender wait for the push
+#define SPI_BUS_STATS_MS 10000 // log per-client SPI bus wait times, 0 = off
+#define PERF_STATS 1 // cycle-counter timing histograms served at /api/stats, 0 = compiled out
+#define TEXT_BENCH_STRINGS 0 // time N strings through print() and GlyphText at boot, 0 = off
+#define PIXEL_BENCH_ROWS 0 // time N rows through each pixel kernel and its scalar loop at boot, 0 = off
+#define LIBRARY_BENCH 0 // time library.bin vs JSON metadata loads for 10/100/1000 GIFs at boot, 0 = off
+#define FRAME_QUEUE_DEPTH 3 // decoded frames kept ahead of the playhead
+#define FRAME_POOL_RESERVE 65536 // heap left free after the frame pool is allocated
+#define PACK_RELEASE_TIMEOUT_MS 500 // longest releasePack() waits for the loader to close its file
+#define RESIDENT_BUDGET (4 * CANVAS_WIDTH * CANVAS_HEIGHT * 2) // default; adjustable via /api/playback
+#define MAX_RESIDENT_FRAMES 16
 
 // Buffers
 #define MAX_ROW_BUFFER ((CANVAS_WIDTH * 3 + 3) & ~3)
 #define MAX_IMAGE_SIZE 128
 #define MAX_GIF_NAME_LEN 32
+#define MAX_GIFS 1000   // library capacity; table indices are int16_t
+#define LIBRARY_GROW 16 // records per library table chunk; chunks never move once allocated
+#define MAX_GIF_FRAMES 512
+
+// Frame scheduling
+#define FRAME_SCHED_POLICY SCHED_DROP // SCHED_CATCH_UP, SCHED_DROP or SCHED_RESYNC
+#define FRAME_LATE_MS 5               // presented this far past its deadline = late
+#define FRAME_RESYNC_MS 1000          // further behind than this always restarts the clock
 
 // Now Playing
 #define NP_DIR "/np"
-#define NP_FRAME_DELAY_MS 400
+#define NP_SCROLL_PX_PER_SEC 30
+#define NP_SCROLL_PAUSE_MS 2000  // rest at each end of the marquee
+#define NP_STRIP_MAX_BYTES 16384 // per title / artist strip
 
 // Upload
 #define UPLOAD_TIMEOUT_MS 30000
@@ -1,5 +1,7 @@
 #include "dice_app.h"
 #include "display.h"
+#include "glyph_text.h"
+#include "pixel_kernels.h"
 #include <Arduino.h>
 
 DiceApp diceApp;
@@ -80,8 +82,8 @@ void DiceApp::updateRoll()
 
 void DiceApp::drawDot(GFXcanvas16 *canvas, int cx, int cy)
 {
-    canvas->fillCircle(cx, cy, 6, 0x0000);       // Black dot
-    canvas->fillCircle(cx, cy, 5, 0x18C3);       // Dark navy fill for depth
+    canvas->fillCircle(cx, cy, 6, 0x0000);              // Black dot
+    canvas->fillCircle(cx, cy, 5, canvasColor(0x18C3)); // Dark navy fill for depth
 }
 
 void DiceApp::drawDiceFace(GFXcanvas16 *canvas, int face)
@@ -90,9 +92,9 @@ void DiceApp::drawDiceFace(GFXcanvas16 *canvas, int face)
     int cx = 64, cy = 64;
 
     // Dice body
-    canvas->fillRoundRect(20, 20, 88, 88, 10, 0xFFFF);   // White face
-    canvas->drawRoundRect(20, 20, 88, 88, 10, 0x0000);   // Black border
-    canvas->drawRoundRect(21, 21, 86, 86, 10, 0x8410);   // Inner shadow
+    canvas->fillRoundRect(20, 20, 88, 88, 10, canvasColor(0xFFFF)); // White face
+    canvas->drawRoundRect(20, 20, 88, 88, 10, 0x0000);              // Black border
+    canvas->drawRoundRect(21, 21, 86, 86, 10, canvasColor(0x8410)); // Inner shadow
 
     // Draw dots
     for (int d = 0; d < DOT_COUNT[f]; d++)
@@ -121,30 +123,21 @@ void DiceApp::loop()
 
     GFXcanvas16 *canvas = display.getBackCanvas();
     if (!canvas) return;
-    canvas->fillScreen(0x0019); // Dark blue background
+    pxFill(canvas->getBuffer(), canvasColor(0x0019), CANVAS_WIDTH * CANVAS_HEIGHT); // Dark blue background
 
     drawDiceFace(canvas, _currentFace);
 
     // Status text
     if (_state == DICE_IDLE)
     {
-        canvas->setTextColor(0xFFFF);
-        canvas->setTextSize(1);
-        canvas->setCursor(22, 116);
-        canvas->print("Shake to roll!");
+        glyphText.draw(canvas, 22, 116, "Shake to roll!", canvasColor(0xFFFF));
     }
     else if (_state == DICE_RESULT)
     {
-        canvas->setTextColor(0xFFE0); // Yellow
-        canvas->setTextSize(1);
-        canvas->setCursor(38, 116);
-        canvas->print("Result: ");
-        canvas->print(_result);
+        char result[16];
+        snprintf(result, sizeof(result), "Result: %d", _result);
+        glyphText.draw(canvas, 38, 116, result, canvasColor(0xFFE0)); // Yellow
     }
 
-    updateOverlay();
-    if (isOverlayVisible())
-        display.drawOverlay(false, display.getTimeString(), name(), 0, 0);
-
     display.swapAndRender();
 }
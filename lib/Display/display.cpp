@@ -1,14 +1,20 @@
 #include "display.h"
+#include "frame_pack.h"
+#include "spi_bus.h"
+#include "pixel_kernels.h"
+#include "perf_stats.h"
 #include <SD.h>
 
 Display display;
 
 Display::Display()
-    : _tft(TFT_CS, TFT_DC, TFT_RST), _frontIdx(0),
-      _lastTimeUpdate(0), _timeSynced(false)
+    : _tft(TFT_CS, TFT_DC, TFT_RST), _bufferCount(0), _scratchLock(NULL),
+      _lastTimeUpdate(0), _timeSynced(false), _clears(0),
+      _bufMux(portMUX_INITIALIZER_UNLOCKED), _drawIdx(-1), _readyIdx(-1), _presentIdx(-1),
+      _readyFull(true), _bufferFreed(NULL), _pushTask(NULL), _lastPushUs(0), _presents(0), _replaced(0)
 {
-    _canvas[0] = nullptr;
-    _canvas[1] = nullptr;
+    for (int i = 0; i < DISPLAY_BUFFERS; i++)
+        _canvas[i] = nullptr;
     strcpy(_timeStr, "--:--");
 }
 
@@ -20,6 +26,8 @@ void Display::begin()
     digitalWrite(TFT_RST, HIGH);
     delay(50);
 
+    _scratchLock = xSemaphoreCreateMutex();
+
     _tft.initR(INITR_BLACKTAB);
     _tft.setRotation(0);
     _tft.fillScreen(ST77XX_BLACK);
@@ -29,32 +37,176 @@ void Display::begin()
     pinMode(SD_CS, OUTPUT);
     digitalWrite(SD_CS, HIGH);
 
-    _canvas[0] = new GFXcanvas16(CANVAS_WIDTH, CANVAS_HEIGHT);
-    _canvas[1] = new GFXcanvas16(CANVAS_WIDTH, CANVAS_HEIGHT);
-    if (!_canvas[0] || !_canvas[1])
+    // Two canvases are required; extra ones are a bonus if the heap allows
+    for (int i = 0; i < DISPLAY_BUFFERS; i++)
+    {
+        GFXcanvas16 *canvas = new GFXcanvas16(CANVAS_WIDTH, CANVAS_HEIGHT);
+        if (!canvas || !canvas->getBuffer())
+        {
+            delete canvas;
+            break;
+        }
+        _canvas[_bufferCount++] = canvas;
+    }
+    if (_bufferCount < 2)
     {
         Serial.println("[Display] Canvas allocation failed!");
         while (1) delay(100);
     }
-    _frontIdx = 0;
+
+    _bufferFreed = xSemaphoreCreateBinary();
+
+#if RENDER_ASYNC
+    // Above the FrameLoader task so a push never waits behind a decode
+    if (_bufferFreed)
+        xTaskCreatePinnedToCore(pushTask, "PanelPush", 3072, this, 2, &_pushTask, 0);
+    if (!_pushTask)
+        Serial.println("[Display] Push task failed, rendering synchronously");
+#endif
+    Serial.printf("[Display] %d canvas buffers\n", _bufferCount);
+}
+
+void Display::pushTask(void *param)
+{
+    Display *self = (Display *)param;
+    int idx;
+    DirtyRect dirty;
+    bool full;
+    for (;;)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        while (self->acquirePresent(idx, dirty, full))
+        {
+            self->renderCanvas(idx, full ? nullptr : &dirty);
+            self->releasePresent();
+        }
+    }
+}
+
+bool Display::acquirePresent(int &idx, DirtyRect &dirty, bool &full)
+{
+    portENTER_CRITICAL(&_bufMux);
+    idx = _readyIdx;
+    if (idx >= 0)
+    {
+        _presentIdx = idx;
+        _readyIdx = -1;
+        dirty = _readyRect;
+        full = _readyFull;
+    }
+    portEXIT_CRITICAL(&_bufMux);
+    return idx >= 0;
+}
+
+void Display::releasePresent()
+{
+    portENTER_CRITICAL(&_bufMux);
+    _presentIdx = -1;
+    portEXIT_CRITICAL(&_bufMux);
+    xSemaphoreGive(_bufferFreed);
+}
+
+GFXcanvas16 *Display::acquireDraw()
+{
+    if (_drawIdx >= 0)
+        return _canvas[_drawIdx];
+    if (_bufferCount == 0)
+        return nullptr;
+
+    // Only waits with two buffers, while one is queued and the other on the wire
+    for (;;)
+    {
+        portENTER_CRITICAL(&_bufMux);
+        for (int i = 0; i < _bufferCount; i++)
+        {
+            if (i != _readyIdx && i != _presentIdx)
+            {
+                _drawIdx = i;
+                break;
+            }
+        }
+        portEXIT_CRITICAL(&_bufMux);
+
+        if (_drawIdx >= 0)
+            return _canvas[_drawIdx];
+        xSemaphoreTake(_bufferFreed, portMAX_DELAY);
+    }
+}
+
+void Display::publish(const DirtyRect *dirty)
+{
+    uint32_t startUs = micros();
+    if (!acquireDraw())
+        return;
+
+    int idx = _drawIdx;
+    _drawIdx = -1;
+
+    if (!_pushTask)
+    {
+        renderCanvas(idx, dirty);
+        logRenderStats(micros() - startUs, _lastPushUs);
+        return;
+    }
+
+    // A frame still queued never reached the panel, so its changes ride along
+    bool superseded = false;
+    portENTER_CRITICAL(&_bufMux);
+    if (_readyIdx >= 0)
+    {
+        superseded = true;
+        _readyFull = _readyFull || !dirty;
+        if (!_readyFull)
+            mergeDirty(_readyRect, *dirty);
+    }
+    else
+    {
+        _readyFull = !dirty;
+        if (dirty)
+            _readyRect = *dirty;
+    }
+    _readyIdx = idx;
+    portEXIT_CRITICAL(&_bufMux);
+
+    if (superseded)
+    {
+        _replaced++;
+        xSemaphoreGive(_bufferFreed);
+    }
+    xTaskNotifyGive(_pushTask);
+    logRenderStats(micros() - startUs, _lastPushUs);
+}
+
+void Display::waitRender()
+{
+    while (renderPending())
+        xSemaphoreTake(_bufferFreed, pdMS_TO_TICKS(20));
 }
 
 void Display::clear()
 {
+    waitRender();
+    spiBus.acquire(SPI_CLIENT_PANEL);
     _tft.fillScreen(ST77XX_BLACK);
+    spiBus.release(SPI_CLIENT_PANEL);
+    _clears++;
 }
 
 void Display::showMessage(const String &msg, int x, int y)
 {
+    waitRender();
+    spiBus.acquire(SPI_CLIENT_PANEL);
     _tft.setCursor(x, y);
     _tft.setTextColor(ST77XX_WHITE);
     _tft.setTextSize(1);
     _tft.print(msg);
+    spiBus.release(SPI_CLIENT_PANEL);
 }
 
 void Display::showIP(const String &ip)
 {
     clear();
+    spiBus.acquire(SPI_CLIENT_PANEL);
     _tft.setCursor(10, 60);
     _tft.setTextColor(ST77XX_WHITE);
     _tft.setTextSize(1);
@@ -62,58 +214,177 @@ void Display::showIP(const String &ip)
     _tft.setCursor(10, 80);
     _tft.print("http://");
     _tft.print(ip);
+    spiBus.release(SPI_CLIENT_PANEL);
 }
 
 void Display::clearBackBuffer()
 {
-    int backIdx = 1 - _frontIdx;
-    if (_canvas[backIdx])
-    {
-        _canvas[backIdx]->fillScreen(ST77XX_BLACK);
-    }
+    GFXcanvas16 *canvas = acquireDraw();
+    if (canvas)
+        canvas->fillScreen(ST77XX_BLACK);
+}
+
+void Display::copyToBackBuffer(const uint16_t *pixels)
+{
+    uint16_t *fb = getBackBuffer();
+    if (fb && pixels)
+        memcpy(fb, pixels, CANVAS_WIDTH * CANVAS_HEIGHT * 2);
 }
 
 uint16_t *Display::getBackBuffer()
 {
-    int backIdx = 1 - _frontIdx;
-    return _canvas[backIdx] ? _canvas[backIdx]->getBuffer() : nullptr;
+    GFXcanvas16 *canvas = acquireDraw();
+    return canvas ? canvas->getBuffer() : nullptr;
 }
 
-GFXcanvas16 *Display::getBackCanvas()
+void Display::renderCanvas(int idx, const DirtyRect *dirty)
 {
-    return _canvas[1 - _frontIdx];
+    uint16_t *buf = _canvas[idx]->getBuffer();
+
+    DirtyRect rect = dirty ? *dirty : DirtyRect{0, 0, CANVAS_WIDTH, CANVAS_HEIGHT};
+    if (rect.w <= 0 || rect.h <= 0)
+    {
+        _lastPushUs = 0;
+        return;
+    }
+
+    spiBus.acquire(SPI_CLIENT_PANEL);
+    uint32_t startUs = micros();
+    uint32_t startCycles = PerfStats::now();
+
+    // Only the changed window goes over SPI, in one call when it spans the full width
+    _tft.startWrite();
+    _tft.setAddrWindow(CANVAS_X + rect.x, CANVAS_Y + rect.y, rect.w, rect.h);
+    uint16_t *row = buf + rect.y * CANVAS_WIDTH + rect.x;
+    if (rect.w == CANVAS_WIDTH)
+    {
+        _tft.writePixels(row, CANVAS_WIDTH * rect.h, true, CANVAS_BIG_ENDIAN);
+    }
+    else
+    {
+        for (int i = 0; i < rect.h; i++, row += CANVAS_WIDTH)
+            _tft.writePixels(row, rect.w, true, CANVAS_BIG_ENDIAN);
+    }
+    _tft.endWrite();
+    perfStats.record(PERF_SPI_PUSH, startCycles);
+    _lastPushUs = micros() - startUs;
+    _presents++;
+    spiBus.release(SPI_CLIENT_PANEL);
 }
 
-void Display::renderCanvas()
+void Display::pushRect(int x, int y, int w, int h, const uint16_t *pixels, int stride)
 {
-    // Render front buffer
-    if (!_canvas[_frontIdx])
+    if (w <= 0 || h <= 0)
         return;
 
+    spiBus.acquire(SPI_CLIENT_PANEL);
     _tft.startWrite();
-    _tft.setAddrWindow(CANVAS_X, CANVAS_Y, CANVAS_WIDTH, CANVAS_HEIGHT);
-    _tft.writePixels(_canvas[_frontIdx]->getBuffer(), CANVAS_WIDTH * CANVAS_HEIGHT);
+    _tft.setAddrWindow(x, y, w, h);
+    uint16_t *row = (uint16_t *)pixels;
+    if (w == stride)
+    {
+        _tft.writePixels(row, w * h, true, CANVAS_BIG_ENDIAN);
+    }
+    else
+    {
+        for (int i = 0; i < h; i++, row += stride)
+            _tft.writePixels(row, w, true, CANVAS_BIG_ENDIAN);
+    }
     _tft.endWrite();
+    spiBus.release(SPI_CLIENT_PANEL);
+}
+
+// Average SPI push time versus how long core 1 actually sat in publish()
+void Display::logRenderStats(uint32_t blockedUs, uint32_t pushUs)
+{
+    static uint32_t frames = 0;
+    static uint32_t totalBlocked = 0;
+    static uint32_t totalPush = 0;
+
+    if (RENDER_STATS_FRAMES == 0)
+        return;
+
+    totalBlocked += blockedUs;
+    totalPush += pushUs;
+    if (++frames < RENDER_STATS_FRAMES)
+        return;
+
+    float blockedMs = totalBlocked / 1000.0f / frames;
+    float pushMs = totalPush / 1000.0f / frames;
+    Serial.printf("[Display] %u frames, push %.1f ms, core 1 blocked %.1f ms (%.1f ms/frame returned), %u superseded\n",
+                  (unsigned)frames, pushMs, blockedMs, pushMs - blockedMs, (unsigned)_replaced);
+    frames = 0;
+    totalBlocked = 0;
+    totalPush = 0;
+    _replaced = 0;
 }
 
-void Display::swapAndRender()
+// Decoder SD access takes the bus per read or seek, so expanding pixels into the
+// canvas never holds off a panel push; client is whoever asked for the decode
+static size_t sdRead(File &f, void *dst, size_t len, SpiClient client)
 {
-    _frontIdx = 1 - _frontIdx;
-    renderCanvas();
+    SpiBusScope bus(client);
+    PerfScope probe(PERF_SD_READ);
+    return f.read((uint8_t *)dst, len);
 }
 
-bool Display::decodeBmpToCanvas(const char *filename)
+static bool sdSeek(File &f, uint32_t pos, SpiClient client)
 {
-    File bmp = SD.open(filename);
+    SpiBusScope bus(client);
+    return f.seek(pos);
+}
+
+// Holds the decoder scratch buffers; the loader task and web previews decode concurrently
+class ScratchScope
+{
+public:
+    explicit ScratchScope(SemaphoreHandle_t lock) : _lock(lock)
+    {
+        if (_lock)
+            xSemaphoreTake(_lock, portMAX_DELAY);
+    }
+    ~ScratchScope()
+    {
+        if (_lock)
+            xSemaphoreGive(_lock);
+    }
+
+private:
+    SemaphoreHandle_t _lock;
+};
+
+// Pixel data on SD is little-endian RGB565; convert it in place once it is in the canvas
+static inline void toCanvasOrder(uint16_t *p, int n)
+{
+    if (CANVAS_BIG_ENDIAN)
+    {
+        PerfScope probe(PERF_PIXEL_CONVERT);
+        pxByteSwap(p, p, n);
+    }
+}
+
+bool Display::decodeBmpToCanvas(const char *filename, uint16_t *fb, SpiClient client)
+{
+    if (!fb)
+        fb = getBackBuffer();
+
+    ScratchScope scratch(_scratchLock);
+
+    File bmp;
+    {
+        SpiBusScope bus(client);
+        PerfScope probe(PERF_SD_OPEN);
+        bmp = SD.open(filename);
+    }
     if (!bmp)
     {
         Serial.printf("[Display] Missing: %s\n", filename);
-        clearBackBuffer();
+        memset(fb, 0, CANVAS_WIDTH * CANVAS_HEIGHT * 2);
         return false;
     }
 
     uint8_t header[54];
-    if (bmp.read(header, 54) != 54 || header[0] != 'B' || header[1] != 'M')
+    if (sdRead(bmp, header, 54, client) != 54 || header[0] != 'B' || header[1] != 'M')
     {
         Serial.println("[Display] Invalid BMP");
         bmp.close();
@@ -146,7 +417,7 @@ bool Display::decodeBmpToCanvas(const char *filename)
     }
 
     if (w < CANVAS_WIDTH || h < CANVAS_HEIGHT)
-        clearBackBuffer();
+        memset(fb, 0, CANVAS_WIDTH * CANVAS_HEIGHT * 2);
 
     int offsetX = (CANVAS_WIDTH - w) >> 1;
     int offsetY = (CANVAS_HEIGHT - h) >> 1;
@@ -159,21 +430,25 @@ bool Display::decodeBmpToCanvas(const char *filename)
     if (offsetX + copyW > CANVAS_WIDTH)
         copyW = CANVAS_WIDTH - offsetX;
 
-    int backIdx = 1 - _frontIdx;
-    uint16_t *fb = _canvas[backIdx]->getBuffer();
+    sdSeek(bmp, dataOffset, client);
 
-    bmp.seek(dataOffset);
+    if (is16bit && w <= CANVAS_WIDTH && h <= CANVAS_HEIGHT)
+    {
+        bool ok = readBmp16Bulk(bmp, fb, w, h, rowSize, offsetX, offsetY, flip, client);
+        bmp.close();
+        return ok;
+    }
 
     for (int row = 0; row < h; row++)
     {
         int canvasRow = offsetY + (flip ? (h - 1 - row) : row);
         if (canvasRow < 0 || canvasRow >= CANVAS_HEIGHT)
         {
-            bmp.seek(bmp.position() + rowSize);
+            sdSeek(bmp, bmp.position() + rowSize, client);
             continue;
         }
 
-        bmp.read(_rowBuf, rowSize);
+        sdRead(bmp, _rowBuf, rowSize, client);
 
         uint16_t *dst = fb + canvasRow * CANVAS_WIDTH + offsetX;
         uint8_t *p = _rowBuf;
@@ -181,24 +456,12 @@ bool Display::decodeBmpToCanvas(const char *filename)
         if (is16bit)
         {
             memcpy(dst, p, copyW * 2);
+            toCanvasOrder(dst, copyW);
         }
         else
         {
-            int i = 0;
-            int fastEnd = copyW - 3;
-            for (; i <= fastEnd; i += 4)
-            {
-                dst[i] = ((p[2] & 0xF8) << 8) | ((p[1] & 0xFC) << 3) | (p[0] >> 3);
-                dst[i + 1] = ((p[5] & 0xF8) << 8) | ((p[4] & 0xFC) << 3) | (p[3] >> 3);
-                dst[i + 2] = ((p[8] & 0xF8) << 8) | ((p[7] & 0xFC) << 3) | (p[6] >> 3);
-                dst[i + 3] = ((p[11] & 0xF8) << 8) | ((p[10] & 0xFC) << 3) | (p[9] >> 3);
-                p += 12;
-            }
-            for (; i < copyW; i++)
-            {
-                dst[i] = ((p[2] & 0xF8) << 8) | ((p[1] & 0xFC) << 3) | (p[0] >> 3);
-                p += 3;
-            }
+            PerfScope probe(PERF_PIXEL_CONVERT);
+            pxConvert888(dst, p, copyW);
         }
     }
 
@@ -206,77 +469,296 @@ bool Display::decodeBmpToCanvas(const char *filename)
     return true;
 }
 
-static void dimCanvasRegion(uint16_t *fb, int y, int h, int w)
+// Pulls all pixel rows in one multi-block read into the canvas region they will
+// occupy, then fixes stride, centering and bottom-up order in place.
+bool Display::readBmp16Bulk(File &bmp, uint16_t *fb, int w, int h, uint32_t rowSize,
+                            int offsetX, int offsetY, bool flip, SpiClient client)
 {
-    for (int row = y; row < y + h && row < CANVAS_HEIGHT; row++)
+    const uint32_t stride = CANVAS_WIDTH * 2;
+    const uint32_t lineBytes = w * 2;
+    uint8_t *base = (uint8_t *)(fb + offsetY * CANVAS_WIDTH);
+
+    size_t bytes = rowSize * h;
+    if (sdRead(bmp, base, bytes, client) != bytes)
+        return false;
+
+    // Spread rows out to the canvas stride, last row first so unread sources stay intact
+    if (rowSize != stride)
+    {
+        for (int r = h - 1; r >= 0; r--)
+        {
+            uint8_t *line = base + r * stride;
+            memmove(line + offsetX * 2, base + r * rowSize, lineBytes);
+            memset(line, 0, offsetX * 2);
+            memset(line + offsetX * 2 + lineBytes, 0, stride - offsetX * 2 - lineBytes);
+        }
+    }
+
+    if (flip)
     {
-        uint16_t *p = fb + row * CANVAS_WIDTH;
-        for (int x = 0; x < w; x++)
+        for (int top = 0, bot = h - 1; top < bot; top++, bot--)
         {
-            p[x] = ((p[x] >> 1) & 0x7BEF);
+            uint8_t *a = base + top * stride;
+            uint8_t *b = base + bot * stride;
+            memcpy(_rowBuf, a, stride);
+            memcpy(a, b, stride);
+            memcpy(b, _rowBuf, stride);
         }
     }
+    toCanvasOrder((uint16_t *)base, h * CANVAS_WIDTH);
+    return true;
 }
 
-void Display::drawOverlay(bool wifiConnected, const char *timeStr,
-                          const char *gifName, int current, int total)
+bool Display::decodeRawToCanvas(File &f, uint32_t offset, int w, int h, uint16_t *fb,
+                                SpiClient client)
 {
-    int backIdx = 1 - _frontIdx;
-    if (!_canvas[backIdx])
-        return;
+    if (w <= 0 || h <= 0 || w > CANVAS_WIDTH || h > CANVAS_HEIGHT || !sdSeek(f, offset, client))
+        return false;
 
-    uint16_t *fb = _canvas[backIdx]->getBuffer();
+    if (!fb)
+        fb = getBackBuffer();
+    if (w < CANVAS_WIDTH || h < CANVAS_HEIGHT)
+        memset(fb, 0, CANVAS_WIDTH * CANVAS_HEIGHT * 2);
 
-    dimCanvasRegion(fb, 0, OVERLAY_HEIGHT, CANVAS_WIDTH);
+    int offsetX = (CANVAS_WIDTH - w) >> 1;
+    int offsetY = (CANVAS_HEIGHT - h) >> 1;
 
-    _canvas[backIdx]->setTextSize(1);
+    uint16_t *dst = fb + offsetY * CANVAS_WIDTH + offsetX;
 
-    _canvas[backIdx]->setCursor(2, 4);
-    if (wifiConnected)
+    // Full-width frames are contiguous in the canvas: one read for the whole frame
+    if (w == CANVAS_WIDTH)
     {
-        _canvas[backIdx]->setTextColor(ST77XX_GREEN);
-        _canvas[backIdx]->print("WiFi");
+        size_t bytes = (size_t)w * h * 2;
+        if (sdRead(f, dst, bytes, client) != bytes)
+            return false;
+        toCanvasOrder(dst, w * h);
+        return true;
     }
-    else
+
+    size_t lineBytes = (size_t)w * 2;
+    for (int row = 0; row < h; row++)
+    {
+        if (sdRead(f, dst, lineBytes, client) != lineBytes)
+            return false;
+        toCanvasOrder(dst, w);
+        dst += CANVAS_WIDTH;
+    }
+    return true;
+}
+
+// Streams the token stream through _rowBuf, so decode needs no more than
+// MAX_ROW_BUFFER bytes of input at a time
+bool Display::decodeRleToCanvas(File &f, uint32_t offset, uint32_t size, int w, int h, uint16_t *fb,
+                                SpiClient client)
+{
+    if (!fb || w <= 0 || h <= 0 || w > CANVAS_WIDTH || h > CANVAS_HEIGHT || !sdSeek(f, offset, client))
+        return false;
+
+    if (w < CANVAS_WIDTH || h < CANVAS_HEIGHT)
+        memset(fb, 0, CANVAS_WIDTH * CANVAS_HEIGHT * 2);
+
+    ScratchScope scratch(_scratchLock);
+    uint16_t *row = fb + ((CANVAS_HEIGHT - h) >> 1) * CANVAS_WIDTH + ((CANVAS_WIDTH - w) >> 1);
+    int x = 0;
+    uint32_t pixelsLeft = (uint32_t)w * h;
+
+    uint32_t inLeft = size;
+    size_t pos = 0, avail = 0;
+    auto nextByte = [&](uint8_t &b) -> bool
+    {
+        if (pos == avail)
+        {
+            avail = sdRead(f, _rowBuf, min((size_t)inLeft, sizeof(_rowBuf)), client);
+            if (avail == 0)
+                return false;
+            inLeft -= avail;
+            pos = 0;
+        }
+        b = _rowBuf[pos++];
+        return true;
+    };
+    auto advance = [&](int n)
+    {
+        x += n;
+        if (x == w)
+        {
+            x = 0;
+            row += CANVAS_WIDTH;
+        }
+    };
+
+    while (pixelsLeft > 0)
+    {
+        uint8_t c, lo, hi;
+        if (!nextByte(c))
+            return false;
+        int count = (c & 0x7F) + 1;
+        if ((uint32_t)count > pixelsLeft)
+            return false;
+        pixelsLeft -= count;
+
+        if (c & RLE_RUN_FLAG)
+        {
+            if (!nextByte(lo) || !nextByte(hi))
+                return false;
+            uint16_t color = canvasColor(lo | (hi << 8));
+            while (count > 0)
+            {
+                int n = min(count, w - x);
+                pxFill(row + x, color, n);
+                advance(n);
+                count -= n;
+            }
+            continue;
+        }
+
+        while (count > 0)
+        {
+            // Copy whole pixels straight out of the buffer; a pixel split across refills goes bytewise
+            int n = min(min(count, w - x), (int)((avail - pos) / 2));
+            if (n == 0)
+            {
+                if (!nextByte(lo) || !nextByte(hi))
+                    return false;
+                row[x] = canvasColor(lo | (hi << 8));
+                n = 1;
+            }
+            else
+            {
+                memcpy(row + x, _rowBuf + pos, n * 2);
+                toCanvasOrder(row + x, n);
+                pos += n * 2;
+            }
+            advance(n);
+            count -= n;
+        }
+    }
+    return true;
+}
+
+bool Display::decodePal8ToCanvas(File &f, uint32_t offset, int w, int h, uint16_t *fb,
+                                 SpiClient client)
+{
+    uint16_t count;
+    if (!fb || w <= 0 || h <= 0 || w > CANVAS_WIDTH || h > CANVAS_HEIGHT || !sdSeek(f, offset, client) ||
+        sdRead(f, &count, 2, client) != 2 || count == 0 || count > 256)
+        return false;
+
+    ScratchScope scratch(_scratchLock);
+    // Unused entries stay black so a stray index can't read stale colors
+    memset(_palette, 0, sizeof(_palette));
+    if (sdRead(f, _palette, count * 2, client) != count * 2u)
+        return false;
+    toCanvasOrder(_palette, count);
+
+    if (w < CANVAS_WIDTH || h < CANVAS_HEIGHT)
+        memset(fb, 0, CANVAS_WIDTH * CANVAS_HEIGHT * 2);
+
+    // Indices are half the size of the output, so several rows fit in _rowBuf per read
+    uint16_t *dst = fb + ((CANVAS_HEIGHT - h) >> 1) * CANVAS_WIDTH + ((CANVAS_WIDTH - w) >> 1);
+    int rowsPerRead = sizeof(_rowBuf) / w;
+    for (int row = 0; row < h;)
     {
-        _canvas[backIdx]->setTextColor(ST77XX_RED);
-        _canvas[backIdx]->print("----");
+        int rows = min(rowsPerRead, h - row);
+        size_t bytes = (size_t)rows * w;
+        if (sdRead(f, _rowBuf, bytes, client) != bytes)
+            return false;
+
+        PerfScope probe(PERF_PIXEL_CONVERT);
+        const uint8_t *idx = _rowBuf;
+        for (int r = 0; r < rows; r++)
+        {
+            for (int x = 0; x < w; x++)
+                dst[x] = _palette[idx[x]];
+            idx += w;
+            dst += CANVAS_WIDTH;
+        }
+        row += rows;
     }
+    return true;
+}
+
+bool Display::applyDeltaToCanvas(File &f, uint32_t offset, int w, int h, uint16_t *fb,
+                                 DirtyRect &dirty, SpiClient client)
+{
+    dirty = {0, 0, 0, 0};
+
+    uint16_t rectCount;
+    if (!fb || !sdSeek(f, offset, client) || sdRead(f, &rectCount, 2, client) != 2)
+        return false;
+
+    int offsetX = (CANVAS_WIDTH - w) >> 1;
+    int offsetY = (CANVAS_HEIGHT - h) >> 1;
+    int x0 = CANVAS_WIDTH, y0 = CANVAS_HEIGHT, x1 = 0, y1 = 0;
 
-    if (timeStr && timeStr[0] != '\0')
+    for (int i = 0; i < rectCount; i++)
     {
-        _canvas[backIdx]->setTextColor(ST77XX_WHITE);
-        int tw = strlen(timeStr) * 6;
-        _canvas[backIdx]->setCursor(CANVAS_WIDTH - tw - 2, 4);
-        _canvas[backIdx]->print(timeStr);
+        PackRect r;
+        if (sdRead(f, &r, sizeof(r), client) != sizeof(r) ||
+            r.w == 0 || r.h == 0 || r.x + r.w > w || r.y + r.h > h)
+            return false;
+
+        int rx = offsetX + r.x;
+        int ry = offsetY + r.y;
+        uint16_t *dst = fb + ry * CANVAS_WIDTH + rx;
+        size_t lineBytes = (size_t)r.w * 2;
+        for (int row = 0; row < r.h; row++)
+        {
+            if (sdRead(f, dst, lineBytes, client) != lineBytes)
+                return false;
+            toCanvasOrder(dst, r.w);
+            dst += CANVAS_WIDTH;
+        }
+
+        x0 = min(x0, rx);
+        y0 = min(y0, ry);
+        x1 = max(x1, rx + r.w);
+        y1 = max(y1, ry + r.h);
     }
 
-    int bottomY = CANVAS_HEIGHT - OVERLAY_HEIGHT;
-    dimCanvasRegion(fb, bottomY, OVERLAY_HEIGHT, CANVAS_WIDTH);
+    if (rectCount > 0)
+        dirty = {(int16_t)x0, (int16_t)y0, (int16_t)(x1 - x0), (int16_t)(y1 - y0)};
+    return true;
+}
 
-    _canvas[backIdx]->setCursor(2, bottomY + 4);
-    _canvas[backIdx]->setTextColor(ST77XX_CYAN);
-    char displayName[16];
-    size_t nameLen = strlen(gifName);
-    if (nameLen > 14)
+bool Display::decodePackFrame(File &f, const PackHeader &hdr, int index, uint16_t *fb,
+                              SpiClient client, uint32_t *bytesRead)
+{
+    PackFrameEntry entry;
+    int key = index;
+    for (; key >= 0; key--)
     {
-        memcpy(displayName, gifName, 12);
-        displayName[12] = '.';
-        displayName[13] = '.';
-        displayName[14] = '\0';
+        if (!FramePack::readEntry(f, hdr, key, entry, client) || entry.offset == 0)
+            return false;
+        if (isKeyframeCodec(entry.codec))
+            break;
     }
+    if (key < 0)
+        return false;
+
+    bool ok;
+    if (entry.codec == PACK_CODEC_RLE)
+        ok = decodeRleToCanvas(f, entry.offset, entry.size, hdr.width, hdr.height, fb, client);
+    else if (entry.codec == PACK_CODEC_PAL8)
+        ok = decodePal8ToCanvas(f, entry.offset, hdr.width, hdr.height, fb, client);
     else
+        ok = decodeRawToCanvas(f, entry.offset, hdr.width, hdr.height, fb, client);
+    if (!ok)
+        return false;
+    if (bytesRead)
+        *bytesRead += entry.size;
+
+    DirtyRect dirty;
+    for (int i = key + 1; i <= index; i++)
     {
-        memcpy(displayName, gifName, nameLen + 1);
+        if (!FramePack::readEntry(f, hdr, i, entry, client) || entry.offset == 0 ||
+            entry.codec != PACK_CODEC_DELTA ||
+            !applyDeltaToCanvas(f, entry.offset, hdr.width, hdr.height, fb, dirty, client))
+            return false;
+        if (bytesRead)
+            *bytesRead += entry.size;
     }
-    _canvas[backIdx]->print(displayName);
-
-    _canvas[backIdx]->setTextColor(ST77XX_YELLOW);
-    char posStr[12];
-    int posLen = snprintf(posStr, sizeof(posStr), "%d/%d", current, total);
-    int pw = posLen * 6;
-    _canvas[backIdx]->setCursor(CANVAS_WIDTH - pw - 2, bottomY + 4);
-    _canvas[backIdx]->print(posStr);
+    return true;
 }
 
 const char *Display::getTimeString()
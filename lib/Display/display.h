@@ -5,6 +5,41 @@
 #include <Adafruit_ST7735.h>
 #include <FS.h>
 #include "config.h"
+#include "spi_bus.h"
+
+struct PackHeader;
+
+// Canvas region that changed since the previous frame; w == 0 means none
+struct DirtyRect
+{
+    int16_t x;
+    int16_t y;
+    int16_t w;
+    int16_t h;
+};
+
+// Grows into to cover other; an empty rect on either side is ignored
+inline void mergeDirty(DirtyRect &into, const DirtyRect &other)
+{
+    if (other.w <= 0 || other.h <= 0)
+        return;
+    if (into.w <= 0 || into.h <= 0)
+    {
+        into = other;
+        return;
+    }
+    int16_t x0 = min(into.x, other.x);
+    int16_t y0 = min(into.y, other.y);
+    int16_t x1 = max(into.x + into.w, other.x + other.w);
+    int16_t y1 = max(into.y + into.h, other.y + other.h);
+    into = {x0, y0, (int16_t)(x1 - x0), (int16_t)(y1 - y0)};
+}
+
+// Value to store in a canvas for an RGB565 color (byte-swapped when CANVAS_BIG_ENDIAN)
+constexpr uint16_t canvasColor(uint16_t c)
+{
+    return CANVAS_BIG_ENDIAN ? (uint16_t)((c << 8) | (c >> 8)) : c;
+}
 
 class Display
 {
@@ -16,26 +51,78 @@ public:
     void showMessage(const String &msg, int x = 10, int y = 70);
     void showIP(const String &ip);
 
-    void swapAndRender();
+    // Canvas ownership (core 1 draws, the push task presents):
+    //   acquireDraw() -> draw -> publish(dirty) -> push task presents -> free
+    // acquireDraw() returns the canvas already held, if any. With three buffers
+    // it never waits: one can be on the wire and one queued. A frame published
+    // before the queued one went out replaces it, and their dirty rects merge.
+    GFXcanvas16 *acquireDraw();
+    // dirty = nullptr pushes the whole canvas; it is relative to the last published frame
+    void publish(const DirtyRect *dirty = nullptr);
+    // Blocks until every published frame has reached the panel
+    void waitRender();
+    bool renderPending() const { return _readyIdx >= 0 || _presentIdx >= 0; }
+    // Canvases that have reached the panel since boot
+    uint32_t presentCount() const { return _presents; }
+
+    void swapAndRender(const DirtyRect *dirty = nullptr) { publish(dirty); }
     uint16_t *getBackBuffer();
-    GFXcanvas16 *getBackCanvas();
+    GFXcanvas16 *getBackCanvas() { return acquireDraw(); }
     void clearBackBuffer();
+    void copyToBackBuffer(const uint16_t *pixels);
 
-    bool decodeBmpToCanvas(const char *filename);
-    void drawOverlay(bool wifiConnected, const char *timeStr,
-                     const char *gifName, int current, int total);
+    // fb = nullptr decodes into the back canvas. SD reads take the bus as client,
+    // so bus stats charge them to whoever asked for the decode.
+    bool decodeBmpToCanvas(const char *filename, uint16_t *fb, SpiClient client);
+    bool decodeRawToCanvas(File &f, uint32_t offset, int w, int h, uint16_t *fb, SpiClient client);
+    bool decodeRleToCanvas(File &f, uint32_t offset, uint32_t size, int w, int h, uint16_t *fb,
+                           SpiClient client);
+    bool decodePal8ToCanvas(File &f, uint32_t offset, int w, int h, uint16_t *fb, SpiClient client);
+    bool applyDeltaToCanvas(File &f, uint32_t offset, int w, int h, uint16_t *fb, DirtyRect &dirty,
+                            SpiClient client);
+    // Frame index of an open pack: a full frame decodes as is, a delta frame is
+    // rebuilt from the full frame before it. bytesRead accumulates payload size.
+    bool decodePackFrame(File &f, const PackHeader &hdr, int index, uint16_t *fb, SpiClient client,
+                         uint32_t *bytesRead = nullptr);
+    // Writes a window of canvas-order pixels straight to the panel, outside the
+    // canvas pipeline; panel coordinates. Used for the status strip bands.
+    void pushRect(int x, int y, int w, int h, const uint16_t *pixels, int stride);
+    // Bumped by clear(), so anything drawn outside the canvas knows to redraw
+    uint32_t clearCount() const { return _clears; }
     const char *getTimeString();
 
 private:
     Adafruit_ST7735 _tft;
-    GFXcanvas16 *_canvas[2];
-    int _frontIdx;
+    GFXcanvas16 *_canvas[DISPLAY_BUFFERS];
+    int _bufferCount;
     uint8_t _rowBuf[MAX_ROW_BUFFER];
+    uint16_t _palette[256];
+    SemaphoreHandle_t _scratchLock; // _rowBuf / _palette, shared by decoders on any task
     char _timeStr[6];
     unsigned long _lastTimeUpdate;
     bool _timeSynced;
+    uint32_t _clears;
+
+    // Buffer roles; a canvas that is none of these is free. Guarded by _bufMux.
+    portMUX_TYPE _bufMux;
+    int _drawIdx;             // core 1 only
+    volatile int _readyIdx;   // published, waiting for the push task
+    volatile int _presentIdx; // on the wire
+    bool _readyFull;
+    DirtyRect _readyRect;
+    SemaphoreHandle_t _bufferFreed; // given each time a canvas goes back to free
+    TaskHandle_t _pushTask;
+    volatile uint32_t _lastPushUs;
+    volatile uint32_t _presents;
+    uint32_t _replaced; // frames superseded before they were pushed
 
-    void renderCanvas();
+    void renderCanvas(int idx, const DirtyRect *dirty);
+    static void pushTask(void *param);
+    bool acquirePresent(int &idx, DirtyRect &dirty, bool &full);
+    void releasePresent();
+    void logRenderStats(uint32_t blockedUs, uint32_t pushUs);
+    bool readBmp16Bulk(File &bmp, uint16_t *fb, int w, int h, uint32_t rowSize,
+                       int offsetX, int offsetY, bool flip, SpiClient client);
 };
 
 extern Display display;
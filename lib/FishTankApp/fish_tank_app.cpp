@@ -1,15 +1,16 @@
 #include "fish_tank_app.h"
 #include "display.h"
+#include "pixel_kernels.h"
 #include <Arduino.h>
 
 FishTankApp fishTankApp;
 
 // Fish colors
 static const uint16_t FISH_COLORS[] = {
-    0xFD20, // Orange
-    0xF81F, // Magenta
-    0x07FF, // Cyan
-    0xFFE0, // Yellow
+    canvasColor(0xFD20), // Orange
+    canvasColor(0xF81F), // Magenta
+    canvasColor(0x07FF), // Cyan
+    canvasColor(0xFFE0), // Yellow
 };
 
 // Plant X positions (within 128px canvas)
@@ -136,7 +137,7 @@ void FishTankApp::drawBubbles(GFXcanvas16 *canvas)
         int y = (int)_bubbles[i].y;
         int r = _bubbles[i].size;
         // Draw hollow circle for bubble
-        canvas->drawCircle(x, y, r, 0xBDF7); // Light blue/white
+        canvas->drawCircle(x, y, r, canvasColor(0xBDF7)); // Light blue/white
     }
 }
 
@@ -155,15 +156,15 @@ void FishTankApp::drawPlants(GFXcanvas16 *canvas)
             int ey = baseY - (seg + 1) * (height / 3);
             // Gentle sway based on segment
             int sway = (seg == 2) ? 2 : (seg == 1 ? 1 : 0);
-            canvas->drawLine(px, sy, px + sway, ey, 0x07E0); // Green
+            canvas->drawLine(px, sy, px + sway, ey, canvasColor(0x07E0)); // Green
         }
 
         // Draw leaf clusters
         int topY = baseY - height;
         int topX = px + 2;
-        canvas->fillCircle(topX, topY, 4, 0x0400);      // Dark green leaf
-        canvas->fillCircle(topX - 3, topY + 3, 3, 0x0400);
-        canvas->fillCircle(topX + 3, topY + 3, 3, 0x0400);
+        canvas->fillCircle(topX, topY, 4, canvasColor(0x0400)); // Dark green leaf
+        canvas->fillCircle(topX - 3, topY + 3, 3, canvasColor(0x0400));
+        canvas->fillCircle(topX + 3, topY + 3, 3, canvasColor(0x0400));
     }
 }
 
@@ -181,11 +182,9 @@ void FishTankApp::loop()
     if (!canvas) return;
 
     // Draw water background gradient (dark blue at top, lighter below)
-    for (int y = 0; y < 128; y += 8)
-    {
-        uint16_t col = (y < 64) ? 0x0011 : 0x0019;
-        canvas->fillRect(0, y, 128, 8, col);
-    }
+    uint16_t *buf = canvas->getBuffer();
+    pxFill(buf, canvasColor(0x0011), 128 * 64);
+    pxFill(buf + 128 * 64, canvasColor(0x0019), 128 * 64);
 
     drawPlants(canvas);
     drawBubbles(canvas);
@@ -193,9 +192,5 @@ void FishTankApp::loop()
     for (int i = 0; i < NUM_FISH; i++)
         drawFish(canvas, _fish[i]);
 
-    updateOverlay();
-    if (isOverlayVisible())
-        display.drawOverlay(false, display.getTimeString(), name(), 0, 0);
-
     display.swapAndRender();
 }
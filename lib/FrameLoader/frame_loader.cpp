@@ -1,27 +1,372 @@
 #include "frame_loader.h"
 #include "display.h"
 #include "upload_manager.h"
+#include "spi_bus.h"
+#include "perf_stats.h"
+#include <SD.h>
+#include <ArduinoJson.h>
 
 FrameLoader frameLoader;
 
 TaskHandle_t FrameLoader::_task = NULL;
-volatile bool FrameLoader::_frameLoaded = false;
-volatile bool FrameLoader::_loaderBusy = false;
-char FrameLoader::_path[64] = {0};
+QueueHandle_t FrameLoader::_freeQueue = NULL;
+QueueHandle_t FrameLoader::_readyQueue = NULL;
+FrameLoader::Slot FrameLoader::_slots[FRAME_QUEUE_DEPTH];
+int FrameLoader::_slotCount = 0;
+portMUX_TYPE FrameLoader::_jobMux = portMUX_INITIALIZER_UNLOCKED;
+FrameLoader::Job FrameLoader::_job;
+volatile uint32_t FrameLoader::_generation = 0;
+volatile bool FrameLoader::_active = false;
+volatile int FrameLoader::_seekFrame = -1;
+volatile bool FrameLoader::_releasePending = false;
+SemaphoreHandle_t FrameLoader::_released = NULL;
+char FrameLoader::_releaseDir[64] = "";
+volatile uint32_t FrameLoader::_detachedGeneration = 0;
+
+uint32_t FrameLoader::_residentBudget = RESIDENT_BUDGET;
+FrameLoader::Slot FrameLoader::_resident[MAX_RESIDENT_FRAMES];
+volatile uint32_t FrameLoader::_residentGeneration = 0;
+volatile int FrameLoader::_residentLoaded = 0;
+
+int FrameLoader::_heldSlot = -1;
+bool FrameLoader::_heldResident = false;
+int FrameLoader::_cursor = 0;
+int FrameLoader::_playCount = 0;
+bool FrameLoader::_starved = true;
+uint32_t FrameLoader::_underruns = 0;
+
+File FrameLoader::_pack;
+PackHeader FrameLoader::_packHdr;
+char FrameLoader::_packPath[64] = {0};
+GifDecoder FrameLoader::_gif;
+uint32_t FrameLoader::_jobGeneration = 0;
+int FrameLoader::_residentCount = 0;
+const uint16_t *FrameLoader::_prevPixels = nullptr;
+int FrameLoader::_prevIndex = -1;
+uint32_t FrameLoader::_bytesRead = 0;
+
+static const DirtyRect FULL_FRAME = {0, 0, CANVAS_WIDTH, CANVAS_HEIGHT};
+
+void FrameLoader::closePack()
+{
+    if (_pack)
+        _pack.close();
+    _gif.close();
+    _packPath[0] = '\0';
+    _prevPixels = nullptr;
+    _prevIndex = -1;
+}
+
+// Called at every point where the task can wait, so releasePack() is never
+// stuck behind a wait that the caller itself is holding up (e.g. an upload)
+void FrameLoader::serviceRelease()
+{
+    if (!_releasePending)
+        return;
+    closePack();
+
+    // _job is what the task picks up next, so a job from gifDir never reopens its files
+    portENTER_CRITICAL(&_jobMux);
+    size_t len = strlen(_releaseDir);
+    if (len > 0 && strncmp(_job.path, _releaseDir, len) == 0 &&
+        (_job.path[len] == '\0' || _job.path[len] == '/'))
+        _detachedGeneration = _generation;
+    portEXIT_CRITICAL(&_jobMux);
+
+    _releasePending = false;
+    xSemaphoreGive(_released);
+}
+
+bool FrameLoader::loadPackFrame(const char *path, int index, uint16_t *fb, DirtyRect &dirty)
+{
+    // Keep one handle open per animation; only reopen when the pack changes
+    if (!_pack || strcmp(_packPath, path) != 0)
+    {
+        closePack();
+        {
+            SpiBusScope bus(SPI_CLIENT_LOADER);
+            PerfScope probe(PERF_SD_OPEN);
+            _pack = SD.open(path, FILE_READ);
+        }
+        if (!_pack || !FramePack::readHeader(_pack, _packHdr, SPI_CLIENT_LOADER))
+        {
+            Serial.printf("[FrameLoader] Bad pack: %s\n", path);
+            closePack();
+            return false;
+        }
+        strlcpy(_packPath, path, sizeof(_packPath));
+    }
+
+    PackFrameEntry entry;
+    if (!FramePack::readEntry(_pack, _packHdr, index, entry, SPI_CLIENT_LOADER) || entry.offset == 0)
+    {
+        Serial.printf("[FrameLoader] Missing frame %d in %s\n", index, path);
+        return false;
+    }
+
+    // Deltas patch frame index - 1 when it is the frame decoded last
+    if (entry.codec == PACK_CODEC_DELTA && index > 0 && _prevIndex == index - 1 && _prevPixels)
+    {
+        if (_prevPixels != fb)
+            memcpy(fb, _prevPixels, FRAME_BYTES);
+        _bytesRead += entry.size;
+        return display.applyDeltaToCanvas(_pack, entry.offset, _packHdr.width, _packHdr.height, fb, dirty,
+                                          SPI_CLIENT_LOADER);
+    }
+
+    // A full frame, or a delta after a seek: replay from the last full frame
+    dirty = FULL_FRAME;
+    return display.decodePackFrame(_pack, _packHdr, index, fb, SPI_CLIENT_LOADER, &_bytesRead);
+}
+
+bool FrameLoader::loadGifFrame(const char *path, int index, uint16_t *fb, DirtyRect &dirty, uint16_t &delay)
+{
+    if (!_gif.isOpen() || strcmp(_gif.path(), path) != 0)
+    {
+        closePack();
+        if (!_gif.open(path))
+            return false;
+    }
+
+    // Every GIF frame builds on the one before. Going forward decodes on from the
+    // last frame (skipping ahead costs only the frames in between); a freshly
+    // opened file, going backwards or losing the previous frame replays from the
+    // first image.
+    uint32_t start = _gif.position();
+    bool ok = true;
+    int from = _gif.nextIndex();
+    bool rewound = from == 0 || !(_prevPixels && _prevIndex == from - 1 && index >= from);
+    if (rewound)
+    {
+        ok = _gif.rewind(fb);
+        start = _gif.position();
+        from = 0;
+    }
+    else if (_prevPixels != fb)
+    {
+        memcpy(fb, _prevPixels, FRAME_BYTES);
+    }
+    for (int i = from; ok && i <= index; i++)
+        ok = _gif.decodeNext(fb, dirty, delay);
+    // The change from index - 1 is only known when exactly one image was decoded
+    if (rewound || index > from)
+        dirty = FULL_FRAME;
+    _bytesRead += _gif.position() - start;
+
+    if (!ok)
+        Serial.printf("[FrameLoader] GIF decode failed at frame %d: %s\n", index, path);
+    return ok;
+}
+
+bool FrameLoader::decodeFrame(const Job &job, int index, Slot &slot)
+{
+    uint16_t *fb = slot.pixels;
+    bool ok;
+    slot.delay = 0;
+    if (_detachedGeneration == _jobGeneration)
+    {
+        ok = false; // its GIF is being deleted
+    }
+    else if (job.source == FRAME_SOURCE_PACK)
+    {
+        ok = loadPackFrame(job.path, index, fb, slot.dirty);
+    }
+    else if (job.source == FRAME_SOURCE_GIF)
+    {
+        ok = loadGifFrame(job.path, index, fb, slot.dirty, slot.delay);
+    }
+    else
+    {
+        static char framePath[64];
+        snprintf(framePath, sizeof(framePath), "%s/%d.bmp", job.path, index);
+        slot.dirty = FULL_FRAME;
+        ok = display.decodeBmpToCanvas(framePath, fb, SPI_CLIENT_LOADER);
+        _bytesRead += FRAME_BYTES; // 16-bit BMP payload, headers not counted
+    }
+
+    _prevPixels = fb;
+    _prevIndex = ok ? index : -1;
+    return ok;
+}
+
+static void logThroughput(uint32_t decodeUs, uint32_t bytesRead)
+{
+    static uint32_t frames = 0;
+    static uint32_t totalUs = 0;
+    static uint32_t totalBytes = 0;
+
+    if (LOADER_STATS_FRAMES == 0)
+        return;
+
+    totalUs += decodeUs;
+    totalBytes += bytesRead;
+    if (++frames < LOADER_STATS_FRAMES)
+        return;
+
+    float avgMs = totalUs / 1000.0f / frames;
+    Serial.printf("[FrameLoader] %u frames, avg decode %.1f ms (%.1f frames/s), %.1f KB read/frame\n",
+                  (unsigned)frames, avgMs, 1000.0f / avgMs, totalBytes / 1024.0f / frames);
+    frames = 0;
+    totalUs = 0;
+    totalBytes = 0;
+}
+
+bool FrameLoader::loadResident(const Job &job, uint32_t generation)
+{
+    // Take every ring slot back; the consumer only hands stale ones in from here on
+    uint8_t id;
+    int owned = 0;
+    while (owned < _slotCount)
+    {
+        if (xQueueReceive(_freeQueue, &id, 0) == pdTRUE || xQueueReceive(_readyQueue, &id, 0) == pdTRUE)
+        {
+            owned++;
+        }
+        else
+        {
+            serviceRelease();
+            vTaskDelay(1);
+        }
+    }
+
+    int n = job.frameCount;
+    for (int i = 0; i < n; i++)
+    {
+        uint16_t *pixels = nullptr;
+        if (i < _slotCount)
+            pixels = _slots[i].pixels;
+        else if (ESP.getFreeHeap() >= FRAME_BYTES + FRAME_POOL_RESERVE)
+            pixels = (uint16_t *)malloc(FRAME_BYTES);
+
+        if (!pixels)
+        {
+            Serial.printf("[FrameLoader] No heap for %d resident frames, streaming\n", n);
+            dropResident();
+            return false;
+        }
+        _resident[i].pixels = pixels;
+        _residentCount = i + 1;
+    }
+
+    _residentLoaded = 0;
+    _residentGeneration = generation;
+
+    for (int i = 0; i < n; i++)
+    {
+        serviceRelease();
+        while (uploadManager.isUploading() && _generation == generation)
+        {
+            serviceRelease();
+            vTaskDelay(pdMS_TO_TICKS(20));
+        }
+        if (_generation != generation)
+            return true; // superseded, the task loop gives the buffers back
+
+        Slot &frame = _resident[i];
+        frame.ok = decodeFrame(job, i, frame);
+        frame.index = i;
+        _residentLoaded = i + 1;
+    }
+
+    closePack();
+    Serial.printf("[FrameLoader] %d frames resident (%u KB)\n",
+                  n, (unsigned)(n * FRAME_BYTES / 1024));
+    return true;
+}
+
+void FrameLoader::dropResident()
+{
+    for (int i = _slotCount; i < _residentCount; i++)
+        free(_resident[i].pixels);
+
+    _residentLoaded = 0;
+    _residentCount = 0;
+    _prevPixels = nullptr;
+    _prevIndex = -1;
+
+    for (uint8_t id = 0; id < _slotCount; id++)
+        xQueueSend(_freeQueue, &id, 0);
+}
 
 void FrameLoader::loaderTask(void *param)
 {
+    Job job;
+    uint32_t jobGeneration = 0;
+    bool haveJob = false;
+    bool residentPending = false;
+    int next = 0;
+
     for (;;)
     {
-        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        serviceRelease();
+
+        portENTER_CRITICAL(&_jobMux);
+        bool active = _active;
+        uint32_t generation = _generation;
+        if (active && (!haveJob || generation != jobGeneration))
+        {
+            job = _job;
+            jobGeneration = generation;
+            _jobGeneration = generation;
+            haveJob = true;
+            residentPending = job.resident;
+            next = job.startFrame;
+            _prevPixels = nullptr;
+            _prevIndex = -1;
+        }
+        if (active && _seekFrame >= 0)
+        {
+            next = _seekFrame;
+            _seekFrame = -1;
+        }
+        portEXIT_CRITICAL(&_jobMux);
 
-        if (uploadManager.isUploading())
+        if (_residentCount > 0 && (!active || generation != _residentGeneration))
+            dropResident();
+
+        if (!active || uploadManager.isUploading())
+        {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(20));
+            continue;
+        }
+
+        if (residentPending)
+        {
+            residentPending = false;
+            if (loadResident(job, generation))
+                continue;
+        }
+
+        // Resident playback needs nothing from the card
+        if (_residentCount > 0)
+        {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(20));
+            continue;
+        }
+
+        uint8_t id;
+        if (xQueueReceive(_freeQueue, &id, pdMS_TO_TICKS(20)) != pdTRUE)
             continue;
 
-        _loaderBusy = true;
-        if (display.decodeBmpToCanvas(_path))
-            _frameLoaded = true;
-        _loaderBusy = false;
+        if (next >= job.frameCount)
+            next = 0;
+
+        // The decoders take the bus per SD read, so a panel push only ever waits
+        // for one read, never for pixel expansion or LZW
+        Slot &slot = _slots[id];
+        uint32_t startUs = micros();
+        _bytesRead = 0;
+        slot.ok = decodeFrame(job, next, slot);
+        slot.index = next;
+        slot.generation = generation;
+
+        if (slot.ok)
+            logThroughput(micros() - startUs, _bytesRead);
+        else
+            vTaskDelay(pdMS_TO_TICKS(20)); // don't hammer the card on a broken frame
+
+        xQueueSend(_readyQueue, &id, 0);
+        next = (next + 1) % job.frameCount;
     }
 }
 
@@ -30,6 +375,33 @@ void FrameLoader::begin()
     if (_task != NULL)
         return;
 
+    loadSettings();
+    if (_released == NULL)
+        _released = xSemaphoreCreateBinary();
+
+    // Fixed pool: at least one slot, more only while FRAME_POOL_RESERVE stays free
+    for (int i = 0; i < FRAME_QUEUE_DEPTH; i++)
+    {
+        if (i > 0 && ESP.getFreeHeap() < FRAME_BYTES + FRAME_POOL_RESERVE)
+            break;
+        uint16_t *pixels = (uint16_t *)malloc(FRAME_BYTES);
+        if (!pixels)
+            break;
+        _slots[i].pixels = pixels;
+        _slotCount++;
+    }
+
+    if (_slotCount == 0)
+    {
+        Serial.println("[FrameLoader] Frame pool allocation failed!");
+        return;
+    }
+
+    _freeQueue = xQueueCreate(_slotCount, sizeof(uint8_t));
+    _readyQueue = xQueueCreate(_slotCount, sizeof(uint8_t));
+    for (uint8_t id = 0; id < _slotCount; id++)
+        xQueueSend(_freeQueue, &id, 0);
+
     xTaskCreatePinnedToCore(
         loaderTask,
         "FrameLoader",
@@ -38,19 +410,191 @@ void FrameLoader::begin()
         1,
         &_task,
         0);
-    Serial.println("[FrameLoader] Started on Core 0");
+    Serial.printf("[FrameLoader] Started on Core 0, %d frame slots. Free heap: %u\n",
+                  _slotCount, ESP.getFreeHeap());
 }
 
-void FrameLoader::requestLoad(const char *path)
+void FrameLoader::play(const char *path, FrameSource source, int frameCount, int startFrame,
+                       bool resident)
 {
-    strlcpy(_path, path, sizeof(_path));
-    _frameLoaded = false;
+    if (frameCount <= 0)
+    {
+        stop();
+        return;
+    }
+
+    release();
+    _cursor = startFrame;
+    _playCount = frameCount;
+
+    portENTER_CRITICAL(&_jobMux);
+    strlcpy(_job.path, path, sizeof(_job.path));
+    _job.source = source;
+    _job.resident = resident && fitsResident(frameCount);
+    _job.frameCount = frameCount;
+    _job.startFrame = startFrame;
+    _seekFrame = -1;
+    _generation++;
+    _active = true;
+    portEXIT_CRITICAL(&_jobMux);
+
+    _starved = true;
     if (_task != NULL)
         xTaskNotifyGive(_task);
 }
 
-void FrameLoader::waitIdle()
+void FrameLoader::stop()
+{
+    release();
+
+    portENTER_CRITICAL(&_jobMux);
+    _generation++;
+    _active = false;
+    portEXIT_CRITICAL(&_jobMux);
+}
+
+void FrameLoader::skipTo(int frame)
 {
-    while (_loaderBusy)
-        delay(1);
+    _cursor = frame;
+
+    portENTER_CRITICAL(&_jobMux);
+    _seekFrame = frame;
+    portEXIT_CRITICAL(&_jobMux);
+}
+
+bool FrameLoader::acquire(LoadedFrame &frame)
+{
+    if (_readyQueue == NULL)
+        return false;
+
+    if (_residentGeneration == _generation && _playCount > 0)
+    {
+        if (_cursor >= _residentLoaded)
+        {
+            _starved = true; // still decoding, not an underrun
+            return false;
+        }
+
+        const Slot &slot = _resident[_cursor];
+        frame.pixels = slot.ok ? slot.pixels : nullptr;
+        frame.index = _cursor;
+        frame.dirty = slot.dirty;
+        frame.delay = slot.delay;
+        _heldResident = true;
+        _starved = false;
+        return true;
+    }
+
+    if (_heldSlot < 0)
+    {
+        uint8_t id;
+        for (;;)
+        {
+            if (xQueueReceive(_readyQueue, &id, 0) != pdTRUE)
+            {
+                // Count once per stall, not once per poll
+                if (_active && !_starved)
+                {
+                    _starved = true;
+                    _underruns++;
+                }
+                return false;
+            }
+            if (_slots[id].generation == _generation)
+                break;
+            xQueueSend(_freeQueue, &id, 0); // left over from a previous animation
+        }
+        _heldSlot = id;
+        _starved = false;
+    }
+
+    const Slot &slot = _slots[_heldSlot];
+    frame.pixels = slot.ok ? slot.pixels : nullptr;
+    frame.index = slot.index;
+    frame.dirty = slot.dirty;
+    frame.delay = slot.delay;
+    return true;
+}
+
+void FrameLoader::release()
+{
+    if (_heldResident)
+    {
+        _heldResident = false;
+        _cursor = (_cursor + 1) % _playCount;
+        return;
+    }
+
+    if (_heldSlot < 0)
+        return;
+
+    uint8_t id = _heldSlot;
+    _heldSlot = -1;
+    xQueueSend(_freeQueue, &id, 0);
+}
+
+int FrameLoader::readyCount() const
+{
+    return _readyQueue ? uxQueueMessagesWaiting(_readyQueue) : 0;
+}
+
+bool FrameLoader::fitsResident(int frameCount) const
+{
+    return frameCount > 0 && frameCount <= MAX_RESIDENT_FRAMES &&
+           (uint32_t)frameCount * FRAME_BYTES <= _residentBudget;
+}
+
+int FrameLoader::residentFrames() const
+{
+    return (_residentGeneration == _generation) ? _residentLoaded : 0;
+}
+
+void FrameLoader::loadSettings()
+{
+    File f = SD.open(PLAYBACK_CONFIG_FILE, FILE_READ);
+    if (!f)
+        return;
+
+    JsonDocument doc;
+    if (!deserializeJson(doc, f))
+        _residentBudget = doc["residentBudget"] | (uint32_t)RESIDENT_BUDGET;
+    f.close();
+}
+
+void FrameLoader::setResidentBudget(uint32_t bytes)
+{
+    _residentBudget = min(bytes, (uint32_t)(MAX_RESIDENT_FRAMES * FRAME_BYTES));
+
+    File f = SD.open(PLAYBACK_CONFIG_FILE, FILE_WRITE);
+    if (!f)
+    {
+        Serial.println("[FrameLoader] Failed to save playback config");
+        return;
+    }
+
+    JsonDocument doc;
+    doc["residentBudget"] = _residentBudget;
+    serializeJson(doc, f);
+    f.close();
+    Serial.printf("[FrameLoader] Resident budget: %u KB\n", (unsigned)(_residentBudget / 1024));
+}
+
+bool FrameLoader::releasePack(const char *gifDir)
+{
+    if (_task == NULL)
+        return true;
+
+    portENTER_CRITICAL(&_jobMux);
+    strlcpy(_releaseDir, gifDir ? gifDir : "", sizeof(_releaseDir));
+    portEXIT_CRITICAL(&_jobMux);
+
+    // Drop a give left over from a request that timed out
+    xSemaphoreTake(_released, 0);
+    _releasePending = true;
+    xTaskNotifyGive(_task);
+    if (xSemaphoreTake(_released, pdMS_TO_TICKS(PACK_RELEASE_TIMEOUT_MS)) == pdTRUE)
+        return true;
+
+    Serial.println("[FrameLoader] Pack release timed out");
+    return false;
 }
@@ -2,24 +2,129 @@
 #define FRAME_LOADER_H
 
 #include <Arduino.h>
+#include <FS.h>
+#include "frame_pack.h"
+#include "display.h"
+#include "gif_decoder.h"
 
+enum FrameSource : uint8_t
+{
+    FRAME_SOURCE_BMP_DIR, // directory of <n>.bmp frames
+    FRAME_SOURCE_PACK,    // GIF_PACK_FILE
+    FRAME_SOURCE_GIF,     // GIF file decoded on the fly
+};
+
+struct LoadedFrame
+{
+    const uint16_t *pixels; // nullptr if the frame failed to decode
+    int index;
+    DirtyRect dirty; // change from frame index - 1
+    uint16_t delay;  // ms from the source, 0 if it doesn't carry one
+};
+
+// Core 0 task that keeps a ring of decoded frames ahead of the playhead.
+// Slots come from a fixed pool allocated once in begin(). Resident playback
+// decodes every frame once (ring slots first, extra buffers after) and then
+// plays from RAM without touching the SD card.
 class FrameLoader
 {
 public:
+    static const uint32_t FRAME_BYTES = CANVAS_WIDTH * CANVAS_HEIGHT * 2;
+
     void begin();
-    void requestLoad(const char *path);
-    bool isLoaded() const { return _frameLoaded; }
-    bool isBusy() const { return _loaderBusy; }
-    void consumeLoaded() { _frameLoaded = false; }
-    void waitIdle();
+
+    // path is a pack or GIF file, or a directory of <n>.bmp frames, per source.
+    // resident falls back to streaming if the heap can't hold every frame.
+    void play(const char *path, FrameSource source, int frameCount, int startFrame = 0,
+              bool resident = false);
+    void stop();
+    void skipTo(int frame);
+
+    bool acquire(LoadedFrame &frame);
+    void release();
+
+    // Closes the loader's open pack / GIF file; false if the task did not get
+    // to it within PACK_RELEASE_TIMEOUT_MS (the file may still be open). If the
+    // current job plays from gifDir, its files stay closed until the next play().
+    bool releasePack(const char *gifDir = nullptr);
+
+    int depth() const { return _slotCount; }
+    int readyCount() const;
+    uint32_t underruns() const { return _underruns; }
+
+    bool fitsResident(int frameCount) const;
+    uint32_t residentBudget() const { return _residentBudget; }
+    void setResidentBudget(uint32_t bytes);
+    int residentFrames() const;
 
 private:
+    struct Slot
+    {
+        uint16_t *pixels;
+        int index;
+        uint32_t generation;
+        bool ok;
+        DirtyRect dirty;
+        uint16_t delay;
+    };
+
+    struct Job
+    {
+        char path[64];
+        FrameSource source;
+        bool resident;
+        int frameCount;
+        int startFrame;
+    };
+
     static TaskHandle_t _task;
-    static volatile bool _frameLoaded;
-    static volatile bool _loaderBusy;
-    static char _path[64];
+    static QueueHandle_t _freeQueue;
+    static QueueHandle_t _readyQueue;
+    static Slot _slots[FRAME_QUEUE_DEPTH];
+    static int _slotCount;
+    static portMUX_TYPE _jobMux;
+    static Job _job;
+    static volatile uint32_t _generation;
+    static volatile bool _active;
+    static volatile int _seekFrame;
+    static volatile bool _releasePending;
+    static SemaphoreHandle_t _released; // given by the task once the file is closed
+    static char _releaseDir[64];        // guarded by _jobMux
+    static volatile uint32_t _detachedGeneration; // job whose GIF is being deleted
+
+    static uint32_t _residentBudget;
+    static Slot _resident[MAX_RESIDENT_FRAMES];
+    static volatile uint32_t _residentGeneration;
+    static volatile int _residentLoaded;
+
+    // Consumer (core 1) state
+    static int _heldSlot;
+    static bool _heldResident;
+    static int _cursor;
+    static int _playCount;
+    static bool _starved;
+    static uint32_t _underruns;
+
+    // Owned by the loader task only
+    static File _pack;
+    static PackHeader _packHdr;
+    static char _packPath[64];
+    static GifDecoder _gif;
+    static uint32_t _jobGeneration;
+    static int _residentCount; // > 0 while the task holds every ring slot
+    static const uint16_t *_prevPixels; // last decoded frame, base for delta frames
+    static int _prevIndex;
+    static uint32_t _bytesRead; // SD payload bytes behind the frame being decoded
 
     static void loaderTask(void *param);
+    static bool decodeFrame(const Job &job, int index, Slot &slot);
+    static bool loadPackFrame(const char *path, int index, uint16_t *fb, DirtyRect &dirty);
+    static bool loadGifFrame(const char *path, int index, uint16_t *fb, DirtyRect &dirty, uint16_t &delay);
+    static void closePack();
+    static void serviceRelease();
+    static bool loadResident(const Job &job, uint32_t generation);
+    static void dropResident();
+    static void loadSettings();
 };
 
 extern FrameLoader frameLoader;
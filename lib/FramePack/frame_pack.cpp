@@ -0,0 +1,427 @@
+#include "frame_pack.h"
+#include "spi_bus.h"
+#include <SD.h>
+
+bool FramePack::create(const char *path, int frameCount, int width, int height,
+                       uint16_t defaultDelay, const uint16_t *delays)
+{
+    File f = SD.open(path, FILE_WRITE);
+    if (!f)
+    {
+        Serial.printf("[FramePack] Cannot create: %s\n", path);
+        return false;
+    }
+
+    PackHeader hdr = {};
+    hdr.magic = PACK_MAGIC;
+    hdr.version = PACK_VERSION;
+    hdr.frameCount = frameCount;
+    hdr.width = width;
+    hdr.height = height;
+    hdr.dataEnd = entryOffset(frameCount);
+
+    bool ok = f.write((const uint8_t *)&hdr, sizeof(hdr)) == sizeof(hdr);
+
+    PackFrameEntry batch[16] = {};
+    for (int i = 0; ok && i < frameCount; i += 16)
+    {
+        int n = min(16, frameCount - i);
+        for (int j = 0; j < n; j++)
+        {
+            int k = i + j;
+            batch[j].delay = (delays && k < MAX_GIF_FRAMES && delays[k]) ? delays[k] : defaultDelay;
+        }
+
+        size_t bytes = n * sizeof(PackFrameEntry);
+        ok = f.write((const uint8_t *)batch, bytes) == bytes;
+    }
+
+    f.close();
+    return ok;
+}
+
+bool FramePack::readHeader(File &f, PackHeader &hdr, SpiClient client)
+{
+    SpiBusScope bus(client);
+    if (!f.seek(0) || f.read((uint8_t *)&hdr, sizeof(hdr)) != sizeof(hdr))
+        return false;
+    return hdr.magic == PACK_MAGIC && hdr.version == PACK_VERSION &&
+           hdr.width > 0 && hdr.width <= CANVAS_WIDTH &&
+           hdr.height > 0 && hdr.height <= CANVAS_HEIGHT;
+}
+
+bool FramePack::readEntry(File &f, const PackHeader &hdr, int index, PackFrameEntry &entry,
+                          SpiClient client)
+{
+    if (index < 0 || index >= hdr.frameCount)
+        return false;
+    SpiBusScope bus(client);
+    if (!f.seek(entryOffset(index)))
+        return false;
+    return f.read((uint8_t *)&entry, sizeof(entry)) == sizeof(entry);
+}
+
+bool FramePack::writeEntry(File &f, int index, const PackFrameEntry &entry)
+{
+    if (!f.seek(entryOffset(index)))
+        return false;
+    return f.write((const uint8_t *)&entry, sizeof(entry)) == sizeof(entry);
+}
+
+bool PackFrameWriter::begin(const char *packPath, int index)
+{
+    abort();
+
+    _file = SD.open(packPath, "r+");
+    if (!_file)
+    {
+        Serial.printf("[FramePack] Cannot open: %s\n", packPath);
+        return false;
+    }
+
+    PackFrameEntry old;
+    if (!FramePack::readHeader(_file, _hdr, SPI_CLIENT_UPLOAD) ||
+        index < 0 || index >= _hdr.frameCount ||
+        !FramePack::readEntry(_file, _hdr, index, old, SPI_CLIENT_UPLOAD))
+    {
+        Serial.printf("[FramePack] Bad pack or index %d: %s\n", index, packPath);
+        _file.close();
+        return false;
+    }
+
+    _open = true;
+    _index = index;
+    _payloadOffset = _hdr.dataEnd;
+    _oldOffset = old.offset;
+    _oldSize = old.size;
+    _received = 0;
+    _dataOffset = 0;
+    _rowSize = 0;
+    _flip = false;
+    _headerParsed = false;
+    _codec = PACK_CODEC_RAW565;
+    _deltaHdrPos = 0;
+    _countParsed = false;
+    _rectsLeft = 0;
+    _pixelBytesLeft = 0;
+    _pixelsLeft = 0;
+    _paletteSize = 0;
+    return true;
+}
+
+bool PackFrameWriter::parseHeader()
+{
+    const uint8_t *h = _bmpHeader;
+    if (h[0] != 'B' || h[1] != 'M')
+        return false;
+
+    _dataOffset = h[10] | (h[11] << 8) | (h[12] << 16) | (h[13] << 24);
+    int32_t w = h[18] | (h[19] << 8) | (h[20] << 16) | (h[21] << 24);
+    int32_t ht = h[22] | (h[23] << 8) | (h[24] << 16) | (h[25] << 24);
+    uint16_t bits = h[28] | (h[29] << 8);
+    uint32_t comp = h[30] | (h[31] << 8) | (h[32] << 16) | (h[33] << 24);
+
+    _flip = (ht > 0);
+    if (ht < 0)
+        ht = -ht;
+
+    if (bits != 16 || comp != 3 || w != _hdr.width || ht != _hdr.height || _dataOffset < sizeof(_bmpHeader))
+    {
+        Serial.printf("[FramePack] Unsupported frame: %dx%d %dbpp comp %u\n",
+                      (int)w, (int)ht, bits, (unsigned)comp);
+        return false;
+    }
+
+    _rowSize = (w * 2 + 3) & ~3;
+    _headerParsed = true;
+    return true;
+}
+
+bool PackFrameWriter::writePixels(uint32_t pixPos, const uint8_t *data, size_t len)
+{
+    const uint32_t lineBytes = _hdr.width * 2;
+
+    while (len > 0)
+    {
+        uint32_t row = pixPos / _rowSize;
+        uint32_t col = pixPos % _rowSize;
+        size_t chunk = min((size_t)(_rowSize - col), len);
+
+        if (col < lineBytes)
+        {
+            size_t n = min(chunk, (size_t)(lineBytes - col));
+            uint32_t dstRow = _flip ? (_hdr.height - 1 - row) : row;
+            uint32_t target = _payloadOffset + dstRow * lineBytes + col;
+
+            if (_file.position() != target && !_file.seek(target))
+                return false;
+            if (_file.write(data, n) != n)
+                return false;
+        }
+
+        pixPos += chunk;
+        data += chunk;
+        len -= chunk;
+    }
+    return true;
+}
+
+// Records are walked as they stream past so a truncated or out-of-bounds
+// upload never reaches the frame table
+bool PackFrameWriter::checkDelta(const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len;)
+    {
+        if (_pixelBytesLeft > 0)
+        {
+            size_t n = min((size_t)_pixelBytesLeft, len - i);
+            _pixelBytesLeft -= n;
+            i += n;
+            continue;
+        }
+
+        if (_countParsed && _rectsLeft == 0)
+            return false; // trailing bytes
+
+        _deltaHdr[_deltaHdrPos++] = data[i++];
+        if (!_countParsed && _deltaHdrPos == 2)
+        {
+            _rectsLeft = _deltaHdr[0] | (_deltaHdr[1] << 8);
+            _countParsed = true;
+            _deltaHdrPos = 0;
+            if (_rectsLeft > DELTA_MAX_RECTS)
+                return false;
+        }
+        else if (_countParsed && _deltaHdrPos == sizeof(PackRect))
+        {
+            const PackRect *r = (const PackRect *)_deltaHdr;
+            if (r->w == 0 || r->h == 0 || r->x + r->w > _hdr.width || r->y + r->h > _hdr.height)
+            {
+                Serial.printf("[FramePack] Bad delta rect %d,%d %dx%d\n", r->x, r->y, r->w, r->h);
+                return false;
+            }
+            _pixelBytesLeft = (uint32_t)r->w * r->h * 2;
+            _rectsLeft--;
+            _deltaHdrPos = 0;
+        }
+    }
+    return true;
+}
+
+bool PackFrameWriter::checkRle(const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len;)
+    {
+        if (_pixelBytesLeft > 0)
+        {
+            size_t n = min((size_t)_pixelBytesLeft, len - i);
+            _pixelBytesLeft -= n;
+            i += n;
+            continue;
+        }
+
+        uint8_t c = data[i++];
+        uint32_t count = (c & 0x7F) + 1;
+        if (count > _pixelsLeft)
+            return false; // overruns the frame, or trailing bytes
+        _pixelsLeft -= count;
+        _pixelBytesLeft = (c & RLE_RUN_FLAG) ? 2 : count * 2;
+    }
+    return true;
+}
+
+bool PackFrameWriter::checkPal8(const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len;)
+    {
+        if (_paletteSize == 0)
+        {
+            _deltaHdr[_deltaHdrPos++] = data[i++];
+            if (_deltaHdrPos == 2)
+            {
+                _paletteSize = _deltaHdr[0] | (_deltaHdr[1] << 8);
+                _deltaHdrPos = 0;
+                if (_paletteSize == 0 || _paletteSize > 256)
+                    return false;
+                _pixelBytesLeft = _paletteSize * 2;
+            }
+            continue;
+        }
+
+        if (_pixelBytesLeft > 0)
+        {
+            size_t n = min((size_t)_pixelBytesLeft, len - i);
+            _pixelBytesLeft -= n;
+            i += n;
+            continue;
+        }
+
+        // Every index must land inside the palette
+        size_t n = min((size_t)_pixelsLeft, len - i);
+        if (n < len - i)
+            return false; // trailing bytes
+        for (size_t k = 0; k < n; k++)
+        {
+            if (data[i + k] >= _paletteSize)
+                return false;
+        }
+        _pixelsLeft -= n;
+        i += n;
+    }
+    return true;
+}
+
+bool PackFrameWriter::writeRecord(const uint8_t *data, size_t len)
+{
+    bool ok;
+    if (_codec == PACK_CODEC_DELTA)
+        ok = checkDelta(data, len);
+    else if (_codec == PACK_CODEC_RLE)
+        ok = checkRle(data, len);
+    else
+        ok = checkPal8(data, len);
+    if (!ok)
+        return false;
+
+    uint32_t target = _payloadOffset + (_received - 2);
+    if (_file.position() != target && !_file.seek(target))
+        return false;
+    return _file.write(data, len) == len;
+}
+
+bool PackFrameWriter::recordComplete() const
+{
+    if (_codec == PACK_CODEC_DELTA)
+        return _countParsed && _rectsLeft == 0 && _pixelBytesLeft == 0 && _deltaHdrPos == 0;
+    if (_codec == PACK_CODEC_PAL8)
+        return _paletteSize > 0 && _pixelBytesLeft == 0 && _pixelsLeft == 0;
+    return _pixelsLeft == 0 && _pixelBytesLeft == 0;
+}
+
+bool PackFrameWriter::write(const uint8_t *data, size_t len)
+{
+    if (!_open)
+        return false;
+
+    while (len > 0)
+    {
+        size_t n;
+        if (_received < 2)
+        {
+            n = min((size_t)(2 - _received), len);
+            memcpy(_bmpHeader + _received, data, n);
+            if (_received + n == 2 && _bmpHeader[0] == UPLOAD_TAG0)
+            {
+                if (_bmpHeader[1] == UPLOAD_TAG_DELTA)
+                {
+                    if (_index == 0)
+                    {
+                        Serial.println("[FramePack] Frame 0 must be a full frame");
+                        return false;
+                    }
+                    _codec = PACK_CODEC_DELTA;
+                }
+                else if (_bmpHeader[1] == UPLOAD_TAG_RLE || _bmpHeader[1] == UPLOAD_TAG_PAL8)
+                {
+                    _codec = (_bmpHeader[1] == UPLOAD_TAG_RLE) ? PACK_CODEC_RLE : PACK_CODEC_PAL8;
+                    _pixelsLeft = (uint32_t)_hdr.width * _hdr.height;
+                }
+            }
+        }
+        else if (_codec != PACK_CODEC_RAW565)
+        {
+            n = len;
+            if (!writeRecord(data, n))
+                return false;
+        }
+        else if (_received < sizeof(_bmpHeader))
+        {
+            n = min((size_t)(sizeof(_bmpHeader) - _received), len);
+            memcpy(_bmpHeader + _received, data, n);
+            if (_received + n == sizeof(_bmpHeader) && !parseHeader())
+                return false;
+        }
+        else if (_received < _dataOffset)
+        {
+            n = min((size_t)(_dataOffset - _received), len);
+        }
+        else
+        {
+            uint32_t pixPos = _received - _dataOffset;
+            uint32_t total = _rowSize * _hdr.height;
+            if (pixPos >= total)
+                return true;
+            n = min((size_t)(total - pixPos), len);
+            if (!writePixels(pixPos, data, n))
+                return false;
+        }
+
+        _received += n;
+        data += n;
+        len -= n;
+    }
+    return true;
+}
+
+bool PackFrameWriter::finish()
+{
+    if (!_open)
+        return false;
+
+    bool ok = (_codec != PACK_CODEC_RAW565)
+                  ? recordComplete()
+                  : _headerParsed && _received >= _dataOffset + _rowSize * _hdr.height;
+    if (ok)
+    {
+        PackFrameEntry entry;
+        ok = FramePack::readEntry(_file, _hdr, _index, entry, SPI_CLIENT_UPLOAD);
+        if (ok)
+        {
+            entry.offset = _payloadOffset;
+            entry.size = (_codec != PACK_CODEC_RAW565) ? _received - 2 : _hdr.width * _hdr.height * 2;
+            entry.codec = _codec;
+            // A re-upload that fits goes back into the old slot, so retries don't grow the
+            // file; if the move fails part way the copy at the end is still complete
+            if (_oldOffset != 0 && entry.size <= _oldSize && movePayload(_oldOffset, entry.size))
+            {
+                entry.offset = _oldOffset;
+                if (_oldOffset + _oldSize == _hdr.dataEnd)
+                    _hdr.dataEnd = _oldOffset + entry.size;
+            }
+            else
+            {
+                _hdr.dataEnd = _payloadOffset + entry.size;
+            }
+            ok = FramePack::writeEntry(_file, _index, entry) &&
+                 _file.seek(0) &&
+                 _file.write((const uint8_t *)&_hdr, sizeof(_hdr)) == sizeof(_hdr);
+        }
+    }
+
+    _file.close();
+    _open = false;
+    return ok;
+}
+
+bool PackFrameWriter::movePayload(uint32_t dst, uint32_t size)
+{
+    uint8_t buf[512];
+    for (uint32_t done = 0; done < size;)
+    {
+        size_t n = min((uint32_t)sizeof(buf), size - done);
+        if (!_file.seek(_payloadOffset + done) || _file.read(buf, n) != n ||
+            !_file.seek(dst + done) || _file.write(buf, n) != n)
+            return false;
+        done += n;
+    }
+    return true;
+}
+
+void PackFrameWriter::abort()
+{
+    if (_open)
+    {
+        _file.close();
+        _open = false;
+    }
+}
@@ -0,0 +1,136 @@
+#ifndef FRAME_PACK_H
+#define FRAME_PACK_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include "config.h"
+#include "spi_bus.h"
+
+// Packed animation container (GIF_PACK_FILE):
+//   PackHeader | PackFrameEntry[frameCount] | frame payloads
+// Payloads are appended in upload order; the table maps frame index -> payload.
+// A re-uploaded frame reuses its old payload when the new one fits.
+// Frame 0 is always a full frame so playback can restart from it.
+
+#define PACK_MAGIC 0x31414348 // "HCA1"
+#define PACK_VERSION 1
+
+enum PackCodec : uint8_t
+{
+    PACK_CODEC_RAW565 = 0, // top-down rows of width * 2 bytes, no padding
+    PACK_CODEC_DELTA = 1,  // uint16 rectCount, then per rect: PackRect + w * h pixels
+    PACK_CODEC_RLE = 2,    // tokens over w * h pixels in raster order, see below
+    PACK_CODEC_PAL8 = 3,   // uint16 paletteSize, RGB565 palette[paletteSize], w * h indices
+};
+
+// RLE token: control byte c, n = (c & 0x7F) + 1 pixels.
+// c & 0x80: one pixel repeated n times; otherwise n literal pixels follow.
+#define RLE_RUN_FLAG 0x80
+#define RLE_MAX_COUNT 128
+
+inline bool isKeyframeCodec(uint8_t codec)
+{
+    return codec == PACK_CODEC_RAW565 || codec == PACK_CODEC_RLE || codec == PACK_CODEC_PAL8;
+}
+
+// Delta payloads patch the previous frame; rects are in frame coordinates
+struct __attribute__((packed)) PackRect
+{
+    uint8_t x;
+    uint8_t y;
+    uint8_t w;
+    uint8_t h;
+};
+
+// Uploaded records start with a two-byte tag ("HD" delta, "HR" RLE, "HP" palette), then the payload
+#define UPLOAD_TAG0 'H'
+#define UPLOAD_TAG_DELTA 'D'
+#define UPLOAD_TAG_RLE 'R'
+#define UPLOAD_TAG_PAL8 'P'
+#define DELTA_MAX_RECTS 1024
+
+struct __attribute__((packed)) PackHeader
+{
+    uint32_t magic;
+    uint8_t version;
+    uint8_t flags;
+    uint16_t frameCount;
+    uint16_t width;
+    uint16_t height;
+    uint32_t dataEnd; // append offset for the next payload
+    uint32_t reserved;
+};
+
+struct __attribute__((packed)) PackFrameEntry
+{
+    uint32_t offset; // 0 = frame not uploaded yet
+    uint32_t size;
+    uint16_t delay;
+    uint8_t codec;
+    uint8_t flags;
+};
+
+namespace FramePack
+{
+    inline uint32_t entryOffset(int index)
+    {
+        return sizeof(PackHeader) + (uint32_t)index * sizeof(PackFrameEntry);
+    }
+
+    // delays, if given, holds MAX_GIF_FRAMES entries; 0 or missing -> defaultDelay
+    bool create(const char *path, int frameCount, int width, int height,
+                uint16_t defaultDelay, const uint16_t *delays = nullptr);
+    // Reads take the bus as client (the loader, an upload or a web preview)
+    bool readHeader(File &f, PackHeader &hdr, SpiClient client);
+    bool readEntry(File &f, const PackHeader &hdr, int index, PackFrameEntry &entry, SpiClient client);
+    bool writeEntry(File &f, int index, const PackFrameEntry &entry);
+}
+
+// Streams an uploaded frame into a pack slot. 16-bit BI_BITFIELDS BMPs lose
+// their header and row padding and are flipped top-down on the way in; delta,
+// RLE and palette records are validated and stored as-is.
+class PackFrameWriter
+{
+public:
+    bool begin(const char *packPath, int index);
+    bool write(const uint8_t *data, size_t len);
+    bool finish();
+    void abort();
+    bool isOpen() const { return _open; }
+
+private:
+    File _file;
+    PackHeader _hdr;
+    bool _open = false;
+    int _index = 0;
+    uint32_t _payloadOffset = 0;
+    uint32_t _oldOffset = 0; // earlier upload of this frame, 0 if none to reuse
+    uint32_t _oldSize = 0;
+    uint8_t _codec = PACK_CODEC_RAW565;
+
+    uint8_t _bmpHeader[54];
+    uint32_t _received = 0;
+    uint32_t _dataOffset = 0;
+    uint32_t _rowSize = 0;
+    bool _flip = false;
+    bool _headerParsed = false;
+
+    uint8_t _deltaHdr[4];
+    int _deltaHdrPos = 0;
+    bool _countParsed = false;
+    uint16_t _rectsLeft = 0;
+    uint32_t _pixelBytesLeft = 0;
+    uint32_t _pixelsLeft = 0;
+    uint16_t _paletteSize = 0;
+
+    bool parseHeader();
+    bool writePixels(uint32_t pixPos, const uint8_t *data, size_t len);
+    bool writeRecord(const uint8_t *data, size_t len);
+    bool checkDelta(const uint8_t *data, size_t len);
+    bool checkRle(const uint8_t *data, size_t len);
+    bool checkPal8(const uint8_t *data, size_t len);
+    bool recordComplete() const;
+    bool movePayload(uint32_t dst, uint32_t size);
+};
+
+#endif // FRAME_PACK_H
@@ -0,0 +1,42 @@
+#include "frame_scheduler.h"
+
+FrameScheduler::FrameScheduler(SchedPolicy policy)
+    : _policy(policy), _deadline(0), _presented(0), _late(0), _dropped(0)
+{
+}
+
+void FrameScheduler::reset(unsigned long now)
+{
+    _deadline = now;
+}
+
+void FrameScheduler::presented(unsigned long now, uint16_t delay)
+{
+    long lateness = (long)(now - _deadline);
+    _presented++;
+    if (lateness > FRAME_LATE_MS)
+        _late++;
+
+    if (lateness > FRAME_RESYNC_MS || (_policy == SCHED_RESYNC && lateness > FRAME_LATE_MS))
+        _deadline = now;
+
+    _deadline += delay;
+}
+
+bool FrameScheduler::shouldDrop(unsigned long now, uint16_t nextDelay) const
+{
+    return _policy == SCHED_DROP && (long)(now - (_deadline + nextDelay)) >= 0;
+}
+
+void FrameScheduler::dropped(uint16_t delay)
+{
+    _deadline += delay;
+    _dropped++;
+}
+
+void FrameScheduler::resetStats()
+{
+    _presented = 0;
+    _late = 0;
+    _dropped = 0;
+}
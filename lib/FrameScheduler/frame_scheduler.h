@@ -0,0 +1,43 @@
+#ifndef FRAME_SCHEDULER_H
+#define FRAME_SCHEDULER_H
+
+#include <Arduino.h>
+#include "config.h"
+
+enum SchedPolicy
+{
+    SCHED_CATCH_UP, // show late frames back to back until the clock is caught up
+    SCHED_DROP,     // skip frames whose whole display slot has already passed
+    SCHED_RESYNC    // restart the clock at the late frame, never catch up
+};
+
+// Absolute-deadline frame clock: deadline(n + 1) = deadline(n) + delay(n), so
+// loader lateness does not accumulate into playback drift.
+class FrameScheduler
+{
+public:
+    FrameScheduler(SchedPolicy policy = FRAME_SCHED_POLICY);
+
+    void setPolicy(SchedPolicy policy) { _policy = policy; }
+    SchedPolicy getPolicy() const { return _policy; }
+
+    void reset(unsigned long now);
+    bool isDue(unsigned long now) const { return (long)(now - _deadline) >= 0; }
+    void presented(unsigned long now, uint16_t delay);
+    bool shouldDrop(unsigned long now, uint16_t nextDelay) const;
+    void dropped(uint16_t delay);
+
+    uint32_t presentedFrames() const { return _presented; }
+    uint32_t lateFrames() const { return _late; }
+    uint32_t droppedFrames() const { return _dropped; }
+    void resetStats();
+
+private:
+    SchedPolicy _policy;
+    unsigned long _deadline;
+    uint32_t _presented;
+    uint32_t _late;
+    uint32_t _dropped;
+};
+
+#endif // FRAME_SCHEDULER_H
@@ -1,29 +1,37 @@
 #include "gif_app.h"
 #include "display.h"
+#include "status_strip.h"
 #include "frame_loader.h"
 #include "web_server.h"
-#include <WiFi.h>
+#include <Preferences.h>
 
 GifApp gifApp;
 
 GifApp::GifApp()
-    : _currentIndex(0), _currentFrame(0), _lastFrameTime(0),
-      _needRefresh(false)
+    : _currentIndex(0), _currentFrame(0), _shownFrame(-1),
+      _needRefresh(false), _cursorRestored(false), _cursorPending(false), _cursorSince(0)
 {
     _currentGif.valid = false;
-    _nextFramePath[0] = '\0';
+    _framePath[0] = '\0';
+    _savedCursor[0] = '\0';
 }
 
 void GifApp::onEnter()
 {
     Serial.println("[GifApp] Enter");
     frameLoader.begin();
-    loadGif();
+
+    // Nothing to play yet (empty, or still being scanned): let loop() say so
+    if (gifManager.getGifCount() == 0)
+        _needRefresh = true;
+    else
+        loadGif();
 }
 
 void GifApp::onExit()
 {
     Serial.println("[GifApp] Exit");
+    frameLoader.stop();
 }
 
 void GifApp::loop()
@@ -31,15 +39,16 @@ void GifApp::loop()
     if (_needRefresh)
     {
         _needRefresh = false;
-        gifManager.refresh();
 
         int count = gifManager.getGifCount();
         if (count == 0)
         {
             _currentGif.valid = false;
             _currentIndex = 0;
+            statusStrip.setTitle(name());
+            statusStrip.setPosition(0, 0);
             display.clear();
-            display.showMessage("No GIFs");
+            display.showMessage(gifManager.isScanning() ? "Scanning GIFs..." : "No GIFs");
             display.showIP(webServer.getLocalIP());
         }
         else
@@ -52,6 +61,9 @@ void GifApp::loop()
 
     if (_currentGif.valid && !webServer.isUploading())
         playFrame();
+
+    if (_cursorPending && millis() - _cursorSince >= CURSOR_SAVE_DELAY_MS)
+        saveCursor();
 }
 
 bool GifApp::onTilt(int direction)
@@ -76,13 +88,50 @@ void GifApp::notifyGifChange()
     _needRefresh = true;
 }
 
+void GifApp::restoreCursor()
+{
+    _cursorRestored = true;
+
+    Preferences prefs;
+    if (!prefs.begin(CURSOR_NVS_NAMESPACE, true))
+        return;
+    prefs.getString("gif", _savedCursor, sizeof(_savedCursor));
+    prefs.end();
+
+    int index = gifManager.indexOf(_savedCursor);
+    if (index >= 0)
+    {
+        _currentIndex = index;
+        Serial.printf("[GifApp] Resuming at %s\n", _savedCursor);
+    }
+}
+
+// Only once the GIF has stayed on, so tilting through the library costs no flash writes
+void GifApp::saveCursor()
+{
+    _cursorPending = false;
+    if (!_currentGif.valid || strcmp(_savedCursor, _currentGif.name) == 0)
+        return;
+
+    Preferences prefs;
+    if (!prefs.begin(CURSOR_NVS_NAMESPACE, false))
+        return;
+    if (prefs.putString("gif", _currentGif.name))
+        strlcpy(_savedCursor, _currentGif.name, sizeof(_savedCursor));
+    prefs.end();
+}
+
 void GifApp::loadGif()
 {
+    if (!_cursorRestored && gifManager.getGifCount() > 0)
+        restoreCursor();
+
     Serial.printf("[GifApp] Loading GIF index %d...\n", _currentIndex);
 
-    frameLoader.waitIdle();
+    frameLoader.stop();
+    frameLoader.releasePack();
 
-    if (!gifManager.getGifInfoByIndex(_currentIndex, _currentGif))
+    if (!gifManager.getGifInfoByIndex(_currentIndex, _currentGif, _frameDelays))
     {
         Serial.println("[GifApp] Failed to get GIF info!");
         _currentGif.valid = false;
@@ -90,43 +139,107 @@ void GifApp::loadGif()
     }
 
     _currentFrame = 0;
-    _lastFrameTime = millis();
+    _shownFrame = -1;
+    _scheduler.reset(millis());
+    _cursorPending = true;
+    _cursorSince = millis();
+    statusStrip.setTitle(_currentGif.name);
+    statusStrip.setPosition(_currentIndex + 1, gifManager.getGifCount());
+
+    FrameSource source = FRAME_SOURCE_BMP_DIR;
+    if (_currentGif.original)
+    {
+        source = FRAME_SOURCE_GIF;
+        snprintf(_framePath, sizeof(_framePath), "%s/%s/%s",
+                 GIFS_ROOT, _currentGif.name, GIF_ORIGINAL_FILE);
+    }
+    else if (_currentGif.packed)
+    {
+        source = FRAME_SOURCE_PACK;
+        snprintf(_framePath, sizeof(_framePath), "%s/%s/%s",
+                 GIFS_ROOT, _currentGif.name, GIF_PACK_FILE);
+    }
+    else
+    {
+        snprintf(_framePath, sizeof(_framePath), "%s/%s", GIFS_ROOT, _currentGif.name);
+    }
 
-    snprintf(_nextFramePath, sizeof(_nextFramePath), "/gifs/%s/%d.bmp",
-             _currentGif.name, _currentFrame);
-    frameLoader.requestLoad(_nextFramePath);
+    // Short animations are decoded once and played from RAM
+    bool resident = frameLoader.fitsResident(_currentGif.frameCount);
+    frameLoader.play(_framePath, source, _currentGif.frameCount, 0, resident);
 
-    Serial.printf("[GifApp] Loaded: %s (%d frames, %dx%d, %dms)\n",
+    Serial.printf("[GifApp] Loaded: %s (%d frames, %dx%d, %dms%s%s)\n",
                   _currentGif.name, _currentGif.frameCount,
-                  _currentGif.width, _currentGif.height, _currentGif.defaultDelay);
+                  _currentGif.width, _currentGif.height, _currentGif.defaultDelay,
+                  _currentGif.original ? ", original" : (_currentGif.packed ? ", packed" : ""),
+                  resident ? ", resident" : "");
 }
 
-void GifApp::playFrame()
+uint16_t GifApp::frameDelay(int frame) const
 {
-    unsigned long now = millis();
-    if (now - _lastFrameTime < _currentGif.defaultDelay || !frameLoader.isLoaded())
-        return;
-
-    _lastFrameTime = now;
-    frameLoader.consumeLoaded();
-
-    showOverlay();
-    display.swapAndRender();
+    return (frame < MAX_GIF_FRAMES) ? _frameDelays[frame] : _currentGif.defaultDelay;
+}
 
+void GifApp::advanceFrame()
+{
     _currentFrame++;
     if (_currentFrame >= _currentGif.frameCount)
         _currentFrame = 0;
-
-    snprintf(_nextFramePath, sizeof(_nextFramePath), "/gifs/%s/%d.bmp",
-             _currentGif.name, _currentFrame);
-    frameLoader.requestLoad(_nextFramePath);
 }
 
-void GifApp::showOverlay()
+void GifApp::playFrame()
 {
-    if (!isOverlayVisible())
+    unsigned long now = millis();
+    if (!_scheduler.isDue(now))
         return;
-    bool wifi = (WiFi.status() == WL_CONNECTED);
-    display.drawOverlay(wifi, display.getTimeString(),
-                        _currentGif.name, _currentIndex + 1, gifManager.getGifCount());
+
+    LoadedFrame frame;
+    for (int attempts = 0;; attempts++)
+    {
+        // Underrun, or nothing but broken frames: hold the current frame
+        if (attempts > _currentGif.frameCount || !frameLoader.acquire(frame))
+            return;
+
+        if (frame.index == _currentFrame && frame.pixels)
+            break;
+
+        // Prefetched before a drop, or failed to decode
+        frameLoader.release();
+        if (frame.index == _currentFrame)
+            advanceFrame();
+    }
+
+    // GIF sources report delays as they decode; keep them for frames that get dropped later
+    if (frame.delay && frame.index < MAX_GIF_FRAMES)
+        _frameDelays[frame.index] = frame.delay;
+
+    display.copyToBackBuffer(frame.pixels);
+    DirtyRect dirty = frame.dirty;
+    uint16_t delay = frame.delay ? frame.delay : frameDelay(_currentFrame);
+    frameLoader.release();
+
+    // Push only the changed window when the panel already shows the previous frame
+    bool partial = _shownFrame >= 0 &&
+                   frame.index == (_shownFrame + 1) % _currentGif.frameCount;
+
+    display.swapAndRender(partial ? &dirty : nullptr);
+    _shownFrame = frame.index;
+
+    _scheduler.presented(now, delay);
+    advanceFrame();
+
+    // Never decode frames whose display slot has already passed
+    int skipped = 0;
+    while (skipped + 1 < _currentGif.frameCount &&
+           _scheduler.shouldDrop(millis(), frameDelay(_currentFrame)))
+    {
+        _scheduler.dropped(frameDelay(_currentFrame));
+        advanceFrame();
+        skipped++;
+    }
+
+    // GIF sources decode forward anyway; the frames already queued are discarded
+    // in playFrame() and the loader runs on to the playhead without a seek
+    if (skipped > 0 && !_currentGif.original)
+        frameLoader.skipTo(_currentFrame);
 }
@@ -3,6 +3,7 @@
 
 #include "app.h"
 #include "gif_manager.h"
+#include "frame_scheduler.h"
 
 class GifApp : public App
 {
@@ -16,18 +17,30 @@ public:
     const char *name() const override { return "GIF"; }
 
     void notifyGifChange();
+    FrameScheduler &scheduler() { return _scheduler; }
 
 private:
     int _currentIndex;
     int _currentFrame;
-    unsigned long _lastFrameTime;
+    int _shownFrame;   // frame on the panel, -1 if something else was drawn
+    FrameScheduler _scheduler;
     GifInfo _currentGif;
+    uint16_t _frameDelays[MAX_GIF_FRAMES];
     bool _needRefresh;
-    char _nextFramePath[64];
+    char _framePath[64];
 
+    // Boot cursor: the last GIF that stayed on for CURSOR_SAVE_DELAY_MS, kept in NVS
+    bool _cursorRestored;
+    bool _cursorPending;
+    unsigned long _cursorSince;
+    char _savedCursor[MAX_GIF_NAME_LEN + 1];
+
+    void restoreCursor();
+    void saveCursor();
     void loadGif();
     void playFrame();
-    void showOverlay();
+    void advanceFrame();
+    uint16_t frameDelay(int frame) const;
 };
 
 extern GifApp gifApp;
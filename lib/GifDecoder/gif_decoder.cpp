@@ -0,0 +1,462 @@
+#include "gif_decoder.h"
+#include <SD.h>
+#include "pixel_kernels.h"
+#include "perf_stats.h"
+#include "spi_bus.h"
+
+static const int LZW_MAX_CODES = 4096;
+
+bool GifDecoder::open(const char *path)
+{
+    close();
+
+    {
+        SpiBusScope bus(SPI_CLIENT_LOADER);
+        PerfScope probe(PERF_SD_OPEN);
+        _file = SD.open(path, FILE_READ);
+    }
+    if (!_file)
+    {
+        Serial.printf("[GifDecoder] Missing: %s\n", path);
+        return false;
+    }
+    _pos = _len = 0;
+
+    uint8_t hdr[13];
+    if (!readBytes(hdr, sizeof(hdr)) || memcmp(hdr, "GIF8", 4) != 0)
+    {
+        Serial.printf("[GifDecoder] Not a GIF: %s\n", path);
+        _file.close();
+        return false;
+    }
+
+    _screenW = hdr[6] | (hdr[7] << 8);
+    _screenH = hdr[8] | (hdr[9] << 8);
+    if (_screenW <= 0 || _screenH <= 0 || _screenW > CANVAS_WIDTH || _screenH > CANVAS_HEIGHT)
+    {
+        Serial.printf("[GifDecoder] Unsupported size %dx%d: %s\n", _screenW, _screenH, path);
+        _file.close();
+        return false;
+    }
+    _offsetX = (CANVAS_WIDTH - _screenW) >> 1;
+    _offsetY = (CANVAS_HEIGHT - _screenH) >> 1;
+
+    memset(_globalLut, 0, sizeof(_globalLut));
+    if (hdr[10] & 0x80)
+        readColorTable(_globalLut, 2 << (hdr[10] & 0x07));
+
+    _tables = (Tables *)malloc(sizeof(Tables));
+    if (!_tables)
+    {
+        Serial.println("[GifDecoder] No memory for LZW tables");
+        _file.close();
+        return false;
+    }
+
+    _firstImage = position();
+    _nextIndex = 0;
+    _prevDisposal = 0;
+    strlcpy(_path, path, sizeof(_path));
+    _open = true;
+    return true;
+}
+
+void GifDecoder::close()
+{
+    if (_file)
+        _file.close();
+    free(_tables);
+    free(_restore);
+    _tables = nullptr;
+    _restore = nullptr;
+    _path[0] = '\0';
+    _open = false;
+}
+
+int GifDecoder::readByte()
+{
+    if (_pos == _len)
+    {
+        // The bus is held for the refill only, never across LZW decoding
+        SpiBusScope bus(SPI_CLIENT_LOADER);
+        PerfScope probe(PERF_SD_READ);
+        _len = _file.read(_buf, sizeof(_buf));
+        _pos = 0;
+        if (_len == 0)
+            return -1;
+    }
+    return _buf[_pos++];
+}
+
+bool GifDecoder::readBytes(uint8_t *dst, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        int b = readByte();
+        if (b < 0)
+            return false;
+        dst[i] = b;
+    }
+    return true;
+}
+
+bool GifDecoder::skipSubBlocks()
+{
+    for (;;)
+    {
+        int n = readByte();
+        if (n < 0)
+            return false;
+        if (n == 0)
+            return true;
+        for (int i = 0; i < n; i++)
+        {
+            if (readByte() < 0)
+                return false;
+        }
+    }
+}
+
+void GifDecoder::readColorTable(uint16_t *lut, int count)
+{
+    uint8_t rgb[3];
+    for (int i = 0; i < count && readBytes(rgb, 3); i++)
+        lut[i] = canvasColor(((rgb[0] & 0xF8) << 8) | ((rgb[1] & 0xFC) << 3) | (rgb[2] >> 3));
+}
+
+bool GifDecoder::rewind(uint16_t *fb)
+{
+    if (!_open)
+        return false;
+    {
+        SpiBusScope bus(SPI_CLIENT_LOADER);
+        if (!_file.seek(_firstImage))
+            return false;
+    }
+
+    _pos = _len = 0;
+    _nextIndex = 0;
+    _prevDisposal = 0;
+    memset(fb, 0, CANVAS_WIDTH * CANVAS_HEIGHT * 2);
+    return true;
+}
+
+void GifDecoder::fillRect(uint16_t *fb, int x, int y, int w, int h, uint16_t color)
+{
+    for (int row = 0; row < h; row++)
+    {
+        pxFill(fb + (_offsetY + y + row) * CANVAS_WIDTH + _offsetX + x, color, w);
+    }
+}
+
+// Undo the previous image as its disposal method asks. "Restore to
+// background" clears to black, matching how browsers treat it.
+void GifDecoder::dispose(uint16_t *fb)
+{
+    if (_prevDisposal == 2)
+    {
+        fillRect(fb, _prevX, _prevY, _prevW, _prevH, 0);
+    }
+    else if (_prevDisposal == 3 && _restore)
+    {
+        const uint16_t *src = _restore;
+        for (int row = 0; row < _prevH; row++)
+        {
+            uint16_t *p = fb + (_offsetY + _prevY + row) * CANVAS_WIDTH + _offsetX + _prevX;
+            memcpy(p, src, _prevW * 2);
+            src += _prevW;
+        }
+    }
+}
+
+bool GifDecoder::decodeNext(uint16_t *fb, DirtyRect &dirty, uint16_t &delay)
+{
+    if (!_open)
+        return false;
+
+    uint8_t disposal = 0;
+    _transparent = -1;
+    delay = 0;
+
+    for (;;)
+    {
+        int b = readByte();
+        if (b == 0x2C)
+            break;
+        if (b != 0x21)
+            return false; // trailer, or a broken stream
+
+        int label = readByte();
+        if (label == 0xF9)
+        {
+            uint8_t gce[6];
+            if (!readBytes(gce, sizeof(gce)) || gce[0] != 4)
+                return false;
+            disposal = (gce[1] >> 2) & 0x07;
+            if (gce[1] & 0x01)
+                _transparent = gce[4];
+
+            // Browsers stretch 0-1 cs delays to 100 ms; leave those to the delay table
+            uint16_t cs = gce[2] | (gce[3] << 8);
+            delay = (cs > 1) ? cs * 10 : 0;
+
+            if (gce[5] != 0)
+            {
+                for (int i = 0; i < gce[5]; i++)
+                    readByte();
+                if (!skipSubBlocks())
+                    return false;
+            }
+        }
+        else if (label < 0 || !skipSubBlocks())
+        {
+            return false;
+        }
+    }
+
+    uint8_t desc[9];
+    if (!readBytes(desc, sizeof(desc)))
+        return false;
+
+    int x = desc[0] | (desc[1] << 8);
+    int y = desc[2] | (desc[3] << 8);
+    int w = desc[4] | (desc[5] << 8);
+    int h = desc[6] | (desc[7] << 8);
+    uint8_t flags = desc[8];
+
+    _lut = _globalLut;
+    if (flags & 0x80)
+    {
+        memset(_localLut, 0, sizeof(_localLut));
+        readColorTable(_localLut, 2 << (flags & 0x07));
+        _lut = _localLut;
+    }
+
+    // Previous image's disposal first, and remember what it touched
+    dispose(fb);
+    int dx0 = CANVAS_WIDTH, dy0 = CANVAS_HEIGHT, dx1 = 0, dy1 = 0;
+    if (_prevDisposal == 2 || _prevDisposal == 3)
+    {
+        dx0 = _prevX;
+        dy0 = _prevY;
+        dx1 = _prevX + _prevW;
+        dy1 = _prevY + _prevH;
+    }
+
+    // Pixels outside the logical screen are decoded but never drawn
+    _imgX = x;
+    _imgY = y;
+    _imgW = w;
+    _imgH = h;
+    int cx = min(x, _screenW);
+    int cy = min(y, _screenH);
+    int cw = min(x + w, _screenW) - cx;
+    int ch = min(y + h, _screenH) - cy;
+
+    if (disposal == 3 && cw > 0 && ch > 0)
+    {
+        if (!_restore)
+            _restore = (uint16_t *)malloc(_screenW * _screenH * 2);
+        if (_restore)
+        {
+            uint16_t *dst = _restore;
+            for (int row = 0; row < ch; row++)
+            {
+                memcpy(dst, fb + (_offsetY + cy + row) * CANVAS_WIDTH + _offsetX + cx, cw * 2);
+                dst += cw;
+            }
+        }
+        else
+        {
+            disposal = 1; // no room to save the region: leave the image in place
+        }
+    }
+
+    _fb = fb;
+    _interlaced = flags & 0x40;
+    _outX = 0;
+    _outY = 0;
+    _pass = 0;
+    bool ok = decodeImage();
+
+    _prevDisposal = disposal;
+    _prevX = cx;
+    _prevY = cy;
+    _prevW = max(cw, 0);
+    _prevH = max(ch, 0);
+
+    if (cw > 0 && ch > 0)
+    {
+        dx0 = min(dx0, cx);
+        dy0 = min(dy0, cy);
+        dx1 = max(dx1, cx + cw);
+        dy1 = max(dy1, cy + ch);
+    }
+    if (dx1 > dx0 && dy1 > dy0)
+        dirty = {(int16_t)(_offsetX + dx0), (int16_t)(_offsetY + dy0),
+                 (int16_t)(dx1 - dx0), (int16_t)(dy1 - dy0)};
+    else
+        dirty = {0, 0, 0, 0};
+
+    _nextIndex++;
+    return ok;
+}
+
+int GifDecoder::readCode(int size)
+{
+    while (_bitCount < size)
+    {
+        if (_blockLeft == 0)
+        {
+            if (_blockEnd)
+                return -1;
+            int n = readByte();
+            if (n <= 0)
+            {
+                _blockEnd = true;
+                return -1;
+            }
+            _blockLeft = n;
+        }
+
+        int b = readByte();
+        if (b < 0)
+            return -1;
+        _blockLeft--;
+        _bits |= (uint32_t)b << _bitCount;
+        _bitCount += 8;
+    }
+
+    int code = _bits & ((1 << size) - 1);
+    _bits >>= size;
+    _bitCount -= size;
+    return code;
+}
+
+// Writes `count` pixels from the end of `indices` backwards (LZW strings are
+// built in reverse), advancing through the image rect and interlace passes.
+void GifDecoder::emit(const uint8_t *indices, int count)
+{
+    static const uint8_t passStart[] = {0, 4, 2, 1};
+    static const uint8_t passStep[] = {8, 8, 4, 2};
+
+    while (count > 0)
+    {
+        if (_outY >= _imgH)
+            return;
+
+        uint8_t idx = indices[--count];
+        int sx = _imgX + _outX;
+        int sy = _imgY + _outY;
+        if (idx != _transparent && sx < _screenW && sy < _screenH)
+            _fb[(_offsetY + sy) * CANVAS_WIDTH + _offsetX + sx] = _lut[idx];
+
+        if (++_outX < _imgW)
+            continue;
+
+        _outX = 0;
+        if (!_interlaced)
+        {
+            _outY++;
+            continue;
+        }
+
+        _outY += passStep[_pass];
+        while (_outY >= _imgH && _pass < 3)
+        {
+            _pass++;
+            _outY = passStart[_pass];
+        }
+    }
+}
+
+bool GifDecoder::decodeImage()
+{
+    int minCodeSize = readByte();
+    if (minCodeSize < 2 || minCodeSize > 8)
+        return false;
+
+    _bits = 0;
+    _bitCount = 0;
+    _blockLeft = 0;
+    _blockEnd = false;
+
+    uint16_t *prefix = _tables->prefix;
+    uint8_t *suffix = _tables->suffix;
+    uint8_t *stack = _tables->stack;
+
+    const int clearCode = 1 << minCodeSize;
+    const int endCode = clearCode + 1;
+    int codeSize = minCodeSize + 1;
+    int nextCode = endCode + 1;
+    int oldCode = -1;
+    uint8_t first = 0;
+
+    for (;;)
+    {
+        int code = readCode(codeSize);
+        if (code < 0 || code == endCode)
+            break;
+
+        if (code == clearCode)
+        {
+            codeSize = minCodeSize + 1;
+            nextCode = endCode + 1;
+            oldCode = -1;
+            continue;
+        }
+
+        if (oldCode < 0)
+        {
+            if (code >= clearCode)
+                return false;
+            first = code;
+            stack[0] = first;
+            emit(stack, 1);
+            oldCode = code;
+            continue;
+        }
+
+        int in = code;
+        int sp = 0;
+        if (code >= nextCode)
+        {
+            if (code > nextCode)
+                return false;
+            stack[sp++] = first; // KwKwK case
+            code = oldCode;
+        }
+        while (code >= clearCode)
+        {
+            if (sp >= LZW_MAX_CODES)
+                return false;
+            stack[sp++] = suffix[code];
+            code = prefix[code];
+        }
+        first = code;
+        stack[sp++] = first;
+        emit(stack, sp);
+
+        if (nextCode < LZW_MAX_CODES)
+        {
+            prefix[nextCode] = oldCode;
+            suffix[nextCode] = first;
+            nextCode++;
+            if (nextCode == (1 << codeSize) && codeSize < 12)
+                codeSize++;
+        }
+        oldCode = in;
+    }
+
+    // Drop whatever is left of the data sub-blocks
+    if (!_blockEnd)
+    {
+        while (_blockLeft-- > 0)
+        {
+            if (readByte() < 0)
+                return false;
+        }
+        return skipSubBlocks();
+    }
+    return true;
+}
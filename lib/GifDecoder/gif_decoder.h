@@ -0,0 +1,86 @@
+#ifndef GIF_DECODER_H
+#define GIF_DECODER_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include "config.h"
+#include "display.h"
+
+// Streaming GIF decoder used by the FrameLoader task. Each image is
+// composited onto a full canvas holding the previous frame, honouring
+// disposal, transparency and per-frame delays. The LZW tables live on the
+// heap only while a file is open; the stack footprint stays small.
+class GifDecoder
+{
+public:
+    bool open(const char *path);
+    void close();
+    bool isOpen() const { return _open; }
+    const char *path() const { return _path; }
+    int nextIndex() const { return _nextIndex; }
+    uint32_t position() { return _file.position() - (_len - _pos); }
+
+    // Clears fb to the background and restarts at the first image
+    bool rewind(uint16_t *fb);
+    // Composites image nextIndex() onto fb, which must hold the previous frame.
+    // delay is 0 when the image has no graphic control extension.
+    bool decodeNext(uint16_t *fb, DirtyRect &dirty, uint16_t &delay);
+
+private:
+    struct Tables
+    {
+        uint16_t prefix[4096];
+        uint8_t suffix[4096];
+        uint8_t stack[4097];
+    };
+
+    File _file;
+    char _path[64] = {0};
+    bool _open = false;
+    Tables *_tables = nullptr;
+    uint16_t *_restore = nullptr; // region saved under a "restore previous" image
+
+    int _screenW = 0;
+    int _screenH = 0;
+    int _offsetX = 0;
+    int _offsetY = 0;
+    uint16_t _globalLut[256];
+    uint16_t _localLut[256];
+    uint32_t _firstImage = 0;
+    int _nextIndex = 0;
+
+    // Previous image, disposed before the next one is drawn
+    uint8_t _prevDisposal = 0;
+    int16_t _prevX = 0, _prevY = 0, _prevW = 0, _prevH = 0;
+
+    // Buffered input
+    uint8_t _buf[256];
+    size_t _pos = 0;
+    size_t _len = 0;
+
+    // LZW bit reader over data sub-blocks
+    uint32_t _bits = 0;
+    int _bitCount = 0;
+    int _blockLeft = 0;
+    bool _blockEnd = false;
+
+    // Pixel output for the current image
+    uint16_t *_fb = nullptr;
+    const uint16_t *_lut = nullptr;
+    int _imgX = 0, _imgY = 0, _imgW = 0, _imgH = 0;
+    int _outX = 0, _outY = 0, _pass = 0;
+    bool _interlaced = false;
+    int _transparent = -1;
+
+    int readByte();
+    bool readBytes(uint8_t *dst, size_t len);
+    bool skipSubBlocks();
+    void readColorTable(uint16_t *lut, int count);
+    int readCode(int size);
+    bool decodeImage();
+    void emit(const uint8_t *indices, int count);
+    void dispose(uint16_t *fb);
+    void fillRect(uint16_t *fb, int x, int y, int w, int h, uint16_t color);
+};
+
+#endif // GIF_DECODER_H
@@ -1,13 +1,72 @@
 #include "gif_manager.h"
+#include "frame_pack.h"
+#include "spi_bus.h"
+#include "perf_stats.h"
 #include <SD.h>
+#include <algorithm>
 
 GifManager gifManager;
 
+const size_t GifTable::CHUNK;
+
+bool GifTable::resize(size_t count)
+{
+    if (count > MAX_GIFS)
+        return false;
+    for (size_t c = 0; c * CHUNK < count; c++)
+    {
+        if (!_chunks[c])
+        {
+            _chunks[c] = (GifInfo *)malloc(CHUNK * sizeof(GifInfo));
+            if (!_chunks[c])
+                return false;
+        }
+    }
+    _count = count;
+    return true;
+}
+
+bool GifTable::insert(size_t index, const GifInfo &info)
+{
+    if (index > _count || !resize(_count + 1))
+        return false;
+    for (size_t i = _count - 1; i > index; i--)
+        (*this)[i] = (*this)[i - 1];
+    (*this)[index] = info;
+    return true;
+}
+
+void GifTable::erase(size_t index)
+{
+    for (size_t i = index; i + 1 < _count; i++)
+        (*this)[i] = (*this)[i + 1];
+    _count--;
+}
+
+void GifTable::release()
+{
+    for (auto &chunk : _chunks)
+    {
+        free(chunk);
+        chunk = nullptr;
+    }
+    _count = 0;
+}
+
+void GifTable::swap(GifTable &other)
+{
+    for (size_t c = 0; c < sizeof(_chunks) / sizeof(_chunks[0]); c++)
+        std::swap(_chunks[c], other._chunks[c]);
+    std::swap(_count, other._count);
+}
+
 GifManager::GifManager()
+    : _lock(NULL), _saveLock(NULL), _dirty(false), _dirtySince(0), _saveRequests(0), _saveWrites(0),
+      _scanning(false), _onScanDone(nullptr)
 {
 }
 
-bool GifManager::begin()
+bool GifManager::begin(bool background)
 {
     if (!SD.begin(SD_CS, SPI, SD_SPI_FREQUENCY))
     {
@@ -17,8 +76,12 @@ bool GifManager::begin()
 
     Serial.printf("[GifManager] SD card initialized @ %d MHz\n", SD_SPI_FREQUENCY / 1000000);
 
+    if (_lock == NULL)
+        _lock = xSemaphoreCreateMutex();
+    if (_saveLock == NULL)
+        _saveLock = xSemaphoreCreateMutex();
     ensureDirectory(GIFS_ROOT);
-    return refresh();
+    return refresh(background);
 }
 
 bool GifManager::ensureDirectory(const char *path)
@@ -30,49 +93,294 @@ bool GifManager::ensureDirectory(const char *path)
     return SD.mkdir(path);
 }
 
-bool GifManager::refresh()
+bool GifManager::refresh(bool background)
 {
-    _gifNames.clear();
+    uint32_t startMs = millis();
+    GifTable gifs;
+    bool indexed = loadLibrary(LIBRARY_FILE, gifs);
+    bool interrupted = false;
+    if (!indexed)
+    {
+        // Power lost between writing the temp file and renaming it; it is complete
+        // (the checksum says so) and newer than anything else
+        interrupted = loadLibrary(LIBRARY_TMP_FILE, gifs);
+        indexed = interrupted;
+    }
+    if (!indexed)
+    {
+        // Opening every GIF directory can take seconds
+        if (background && startScan())
+            return true;
+        if (!rebuildLibrary(gifs))
+            return false;
+    }
 
-    if (loadOrder())
+    adoptLibrary(gifs, !indexed, interrupted, startMs);
+    return true;
+}
+
+void GifManager::adoptLibrary(GifTable &gifs, bool rebuilt, bool resave, uint32_t startMs)
+{
+    lock();
+    _gifs.swap(gifs);
+    rebuildIndex();
+    unlock();
+
+    // The index holds the order from now on
+    if (rebuilt && saveLibrary())
+        SD.remove(ORDER_FILE);
+    else if (resave)
+        saveLibrary();
+
+    Serial.printf("[GifManager] %s %d GIFs in %u ms (%u bytes of metadata)\n",
+                  rebuilt ? "Rebuilt" : "Loaded", (int)_gifs.size(),
+                  (unsigned)(millis() - startMs), (unsigned)(_gifs.size() * sizeof(GifInfo)));
+}
+
+// The table stays empty and changes are refused until the task swaps its result in
+bool GifManager::startScan()
+{
+    _scanning = true;
+    if (xTaskCreatePinnedToCore(scanTask, "LibraryScan", 8192, this, 1, NULL, 0) == pdPASS)
     {
-        Serial.printf("[GifManager] Loaded %d GIFs from order\n", _gifNames.size());
+        Serial.println("[GifManager] No index, scanning GIFs in the background");
         return true;
     }
+    _scanning = false;
+    return false;
+}
+
+void GifManager::scanTask(void *param)
+{
+    ((GifManager *)param)->runScan();
+    vTaskDelete(NULL);
+}
+
+void GifManager::runScan()
+{
+    uint32_t startMs = millis();
+    GifTable gifs;
+    bool ok = rebuildLibrary(gifs);
+    // rebuildLibrary() took the bus per directory read; the save runs without it,
+    // like every other library write, so panel pushes and frame loads go on
+    if (ok)
+        adoptLibrary(gifs, true, false, startMs);
+    _scanning = false;
+    perfStats.bootPhase("library scan", startMs);
+
+    if (ok && _onScanDone)
+        _onScanDone();
+}
+
+// hash continues a previous call, so a table can be hashed a chunk at a time
+static uint32_t fnv1a(const void *data, size_t len, uint32_t hash = 2166136261u)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    while (len--)
+    {
+        hash ^= *p++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Header, then the records read straight into the table a chunk at a time
+bool GifManager::loadLibrary(const char *path, GifTable &gifs)
+{
+    File f = SD.open(path, FILE_READ);
+    if (!f)
+        return false;
+
+    LibraryHeader hdr;
+    bool ok = f.read((uint8_t *)&hdr, sizeof(hdr)) == sizeof(hdr) &&
+              hdr.magic == LIBRARY_MAGIC && hdr.version == LIBRARY_VERSION &&
+              hdr.recordSize == sizeof(GifInfo) && hdr.count <= MAX_GIFS &&
+              f.size() == sizeof(hdr) + (size_t)hdr.count * sizeof(GifInfo) &&
+              gifs.resize(hdr.count);
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; ok && i < hdr.count; i += GifTable::CHUNK)
+    {
+        size_t bytes = min(GifTable::CHUNK, hdr.count - i) * sizeof(GifInfo);
+        ok = f.read((uint8_t *)&gifs[i], bytes) == bytes;
+        hash = fnv1a(&gifs[i], bytes, hash);
+    }
+    ok = ok && hash == hdr.checksum;
+    f.close();
 
-    File root = SD.open(GIFS_ROOT);
-    if (!root || !root.isDirectory())
+    if (!ok)
     {
-        Serial.println("[GifManager] Cannot open gifs directory");
+        Serial.printf("[GifManager] %s is corrupt\n", path);
+        gifs.clear();
         return false;
     }
+    for (size_t i = 0; i < gifs.size(); i++)
+        gifs[i].name[MAX_GIF_NAME_LEN] = '\0';
+    return true;
+}
 
-    File entry;
-    while ((entry = root.openNextFile()))
+// Records are copied out a chunk at a time under _lock, so readers never wait on
+// the SD write. A change that lands mid-write marks the library dirty again, and
+// one that changes the count fails the write.
+bool GifManager::writeLibrary(const char *path, const GifTable &gifs)
+{
+    File f = SD.open(path, FILE_WRITE);
+    if (!f)
+    {
+        Serial.printf("[GifManager] Cannot write %s\n", path);
+        return false;
+    }
+
+    lock();
+    size_t count = gifs.size();
+    unlock();
+
+    // The checksum is known only at the end, so the header goes out twice
+    LibraryHeader hdr = {LIBRARY_MAGIC, LIBRARY_VERSION, sizeof(GifInfo), (uint32_t)count, 0};
+    bool ok = f.write((const uint8_t *)&hdr, sizeof(hdr)) == sizeof(hdr);
+    GifInfo chunk[GifTable::CHUNK];
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; ok && i < count; i += GifTable::CHUNK)
+    {
+        size_t bytes = min(GifTable::CHUNK, count - i) * sizeof(GifInfo);
+        lock();
+        ok = gifs.size() == count;
+        if (ok)
+            memcpy(chunk, &gifs[i], bytes);
+        unlock();
+        ok = ok && f.write((const uint8_t *)chunk, bytes) == bytes;
+        hash = fnv1a(chunk, bytes, hash);
+    }
+    hdr.checksum = hash;
+    ok = ok && f.seek(0) && f.write((const uint8_t *)&hdr, sizeof(hdr)) == sizeof(hdr);
+    f.close();
+    return ok;
+}
+
+// FAT rename will not replace an existing file, so the old index goes first. At
+// every point either LIBRARY_FILE or a complete LIBRARY_TMP_FILE is on the card.
+bool GifManager::saveLibrary()
+{
+    if (_saveLock)
+        xSemaphoreTake(_saveLock, portMAX_DELAY);
+    bool ok = writeLibrary(LIBRARY_TMP_FILE, _gifs);
+    if (ok)
+    {
+        SD.remove(LIBRARY_FILE);
+        ok = SD.rename(LIBRARY_TMP_FILE, LIBRARY_FILE);
+        if (!ok)
+            Serial.println("[GifManager] Cannot rename library index");
+    }
+    if (_saveLock)
+        xSemaphoreGive(_saveLock);
+    return ok;
+}
+
+// Caller holds _lock
+void GifManager::markDirty()
+{
+    if (!_dirty)
+        _dirtySince = millis();
+    _dirty = true;
+    _saveRequests++;
+}
+
+void GifManager::loop()
+{
+    if (_dirty && millis() - _dirtySince >= LIBRARY_SAVE_DELAY_MS)
+        flush();
+}
+
+// Clears _dirty before writing, so a change made during the write is saved in the
+// next window; _lock is only taken around the bookkeeping and each chunk copy
+bool GifManager::flush()
+{
+    lock();
+    bool dirty = _dirty;
+    _dirty = false;
+    unlock();
+    if (!dirty)
+        return true;
+
+    bool ok = saveLibrary();
+
+    lock();
+    if (ok)
+    {
+        _saveWrites++;
+    }
+    else if (!_dirty)
+    {
+        _dirty = true;
+        _dirtySince = millis(); // try again after another window
+    }
+    uint32_t requests = _saveRequests;
+    uint32_t writes = _saveWrites;
+    unlock();
+
+    Serial.printf("[GifManager] Library %s (%u changes, %u writes saved)\n",
+                  ok ? "saved" : "save failed", (unsigned)requests, (unsigned)(requests - writes));
+    return ok;
+}
+
+// Index missing or corrupt: legacy order.json (or the directory listing) for the
+// order, each GIF's config.json or pack header for its record
+bool GifManager::rebuildLibrary(GifTable &gifs)
+{
+    std::vector<String> names;
+    spiBus.acquire(SPI_CLIENT_LOADER);
+    if (!loadOrder(names))
     {
-        if (entry.isDirectory())
+        File root = SD.open(GIFS_ROOT);
+        if (!root || !root.isDirectory())
         {
-            String fullPath = entry.name();
-            int lastSlash = fullPath.lastIndexOf('/');
-            String name = (lastSlash >= 0) ? fullPath.substring(lastSlash + 1) : fullPath;
+            spiBus.release(SPI_CLIENT_LOADER);
+            Serial.println("[GifManager] Cannot open gifs directory");
+            return false;
+        }
 
-            if (name.length() > 0 && name[0] != '.')
+        File entry;
+        while ((entry = root.openNextFile()))
+        {
+            if (entry.isDirectory())
             {
-                _gifNames.push_back(name);
+                String fullPath = entry.name();
+                int lastSlash = fullPath.lastIndexOf('/');
+                String name = (lastSlash >= 0) ? fullPath.substring(lastSlash + 1) : fullPath;
+
+                if (name.length() > 0 && name[0] != '.')
+                {
+                    names.push_back(name);
+                }
             }
+            entry.close();
         }
-        entry.close();
+        root.close();
     }
-    root.close();
+    spiBus.release(SPI_CLIENT_LOADER);
 
-    if (!_gifNames.empty())
-        saveOrder();
+    gifs.clear();
+    for (const auto &name : names)
+    {
+        GifInfo info;
+        if (gifs.size() >= MAX_GIFS)
+        {
+            Serial.printf("[GifManager] Library full, skipping %s\n", name.c_str());
+            continue;
+        }
 
-    Serial.printf("[GifManager] Found %d GIFs\n", _gifNames.size());
+        // One bus burst per GIF, so a background scan never holds off the panel for long
+        spiBus.acquire(SPI_CLIENT_LOADER);
+        bool found = loadGifConfig(name, info) || loadPackInfo(name, info);
+        spiBus.release(SPI_CLIENT_LOADER);
+        if (found && !gifs.push_back(info))
+            Serial.printf("[GifManager] No heap for %s\n", name.c_str());
+        else if (!found)
+            Serial.printf("[GifManager] Skipping %s: no config or pack\n", name.c_str());
+    }
     return true;
 }
 
-bool GifManager::loadOrder()
+bool GifManager::loadOrder(std::vector<String> &names)
 {
     File f = SD.open(ORDER_FILE, FILE_READ);
     if (!f)
@@ -91,7 +399,7 @@ bool GifManager::loadOrder()
     }
 
     JsonArray arr = doc["order"].as<JsonArray>();
-    _gifNames.clear();
+    names.clear();
 
     char verifyBuf[64];
     for (JsonVariant v : arr)
@@ -103,48 +411,74 @@ bool GifManager::loadOrder()
             snprintf(verifyBuf, sizeof(verifyBuf), "%s/%s", GIFS_ROOT, name);
             if (SD.exists(verifyBuf))
             {
-                _gifNames.push_back(name);
+                names.push_back(name);
             }
         }
     }
 
-    return !_gifNames.empty();
+    return !names.empty();
 }
 
-bool GifManager::saveOrder()
+int GifManager::indexOf(const char *name)
 {
-    File f = SD.open(ORDER_FILE, FILE_WRITE);
-    if (!f)
-    {
-        Serial.println("[GifManager] Cannot write order file");
-        return false;
-    }
-
-    JsonDocument doc;
-    JsonArray arr = doc["order"].to<JsonArray>();
+    lock();
+    int index = findGif(name);
+    unlock();
+    return index;
+}
 
-    for (const auto &name : _gifNames)
-    {
-        arr.add(name);
-    }
+int GifManager::getGifCount()
+{
+    lock();
+    int count = _gifs.size();
+    unlock();
+    return count;
+}
 
-    serializeJson(doc, f);
-    f.close();
-    return true;
+bool GifManager::getGifName(int index, char *out, size_t outSize)
+{
+    lock();
+    bool found = index >= 0 && index < (int)_gifs.size();
+    if (found)
+        strlcpy(out, _gifs[index].name, outSize);
+    unlock();
+    return found;
 }
 
-int GifManager::getGifCount()
+// Caller holds _lock
+int GifManager::findGif(const char *name) const
 {
-    return _gifNames.size();
+    if (_nameIndex.empty())
+        return -1;
+
+    size_t mask = _nameIndex.size() - 1;
+    for (size_t slot = fnv1a(name, strlen(name)) & mask;; slot = (slot + 1) & mask)
+    {
+        int index = _nameIndex[slot];
+        if (index < 0)
+            return -1;
+        if (strcmp(_gifs[index].name, name) == 0)
+            return index;
+    }
 }
 
-String GifManager::getGifName(int index)
+// After any change that adds, removes or moves records; caller holds _lock.
+// The slot array keeps its allocation unless the library outgrows it.
+void GifManager::rebuildIndex()
 {
-    if (index < 0 || index >= (int)_gifNames.size())
+    size_t slots = 16;
+    while (slots < _gifs.size() * 2)
+        slots <<= 1;
+    _nameIndex.assign(slots, -1);
+
+    size_t mask = slots - 1;
+    for (size_t i = 0; i < _gifs.size(); i++)
     {
-        return "";
+        size_t slot = fnv1a(_gifs[i].name, strlen(_gifs[i].name)) & mask;
+        while (_nameIndex[slot] >= 0)
+            slot = (slot + 1) & mask;
+        _nameIndex[slot] = i;
     }
-    return _gifNames[index];
 }
 
 bool GifManager::loadGifConfig(const String &name, GifInfo &info)
@@ -165,18 +499,78 @@ bool GifManager::loadGifConfig(const String &name, GifInfo &info)
         return false;
     }
 
+    memset(&info, 0, sizeof(info));
     strlcpy(info.name, name.c_str(), sizeof(info.name));
     info.frameCount = doc["frameCount"] | 0;
     info.width = doc["width"] | CANVAS_WIDTH;
     info.height = doc["height"] | CANVAS_HEIGHT;
     info.defaultDelay = doc["defaultDelay"] | 100;
+    info.packed = doc["packed"] | false;
+    info.original = doc["original"] | false;
+    info.delaysOffset = info.packed ? FramePack::entryOffset(0) : 0;
     info.valid = true;
     return true;
 }
 
-bool GifManager::saveGifConfig(const String &name, const GifInfo &info)
+// For a packed GIF that lost its config.json; the header has everything but the delay
+bool GifManager::loadPackInfo(const String &name, GifInfo &info)
 {
-    snprintf(_pathBuf, sizeof(_pathBuf), "%s/%s/%s", GIFS_ROOT, name.c_str(), GIF_CONFIG_FILE);
+    snprintf(_pathBuf, sizeof(_pathBuf), "%s/%s/%s", GIFS_ROOT, name.c_str(), GIF_PACK_FILE);
+    File f = SD.open(_pathBuf, FILE_READ);
+    PackHeader hdr;
+    bool ok = f && FramePack::readHeader(f, hdr, SPI_CLIENT_LOADER);
+    if (f)
+        f.close();
+    if (!ok)
+        return false;
+
+    memset(&info, 0, sizeof(info));
+    strlcpy(info.name, name.c_str(), sizeof(info.name));
+    info.frameCount = hdr.frameCount;
+    info.width = hdr.width;
+    info.height = hdr.height;
+    info.defaultDelay = 100;
+    info.packed = true;
+    info.delaysOffset = FramePack::entryOffset(0);
+    info.valid = true;
+    return true;
+}
+
+// Fills delays[0..MAX_GIF_FRAMES) from the pack's frame table
+bool GifManager::loadFrameDelays(const GifInfo &info, uint16_t *delays)
+{
+    if (!info.packed || !info.delaysOffset)
+        return false;
+
+    // Runs on core 1 while the web server may be using _pathBuf
+    char path[64];
+    snprintf(path, sizeof(path), "%s/%s/%s", GIFS_ROOT, info.name, GIF_PACK_FILE);
+    File f = SD.open(path, FILE_READ);
+    if (!f)
+        return false;
+
+    // The record already has the count and where the table starts; no header read
+    int count = min((int)info.frameCount, MAX_GIF_FRAMES);
+    PackFrameEntry batch[16];
+    bool ok = f.seek(info.delaysOffset);
+    for (int i = 0; ok && i < count; i += 16)
+    {
+        int n = min(16, count - i);
+        size_t bytes = n * sizeof(PackFrameEntry);
+        ok = f.read((uint8_t *)batch, bytes) == bytes;
+        for (int j = 0; ok && j < n; j++)
+            delays[i + j] = batch[j].delay ? batch[j].delay : info.defaultDelay;
+    }
+    f.close();
+
+    for (int i = count; i < MAX_GIF_FRAMES; i++)
+        delays[i] = info.defaultDelay;
+    return ok;
+}
+
+bool GifManager::saveGifConfig(const char *name, const GifInfo &info)
+{
+    snprintf(_pathBuf, sizeof(_pathBuf), "%s/%s/%s", GIFS_ROOT, name, GIF_CONFIG_FILE);
 
     File f = SD.open(_pathBuf, FILE_WRITE);
     if (!f)
@@ -190,30 +584,57 @@ bool GifManager::saveGifConfig(const String &name, const GifInfo &info)
     doc["width"] = info.width;
     doc["height"] = info.height;
     doc["defaultDelay"] = info.defaultDelay;
+    doc["packed"] = info.packed;
+    doc["original"] = info.original;
 
     serializeJson(doc, f);
     f.close();
     return true;
 }
 
-bool GifManager::getGifInfo(const String &name, GifInfo &info)
+bool GifManager::getGifInfo(const char *name, GifInfo &info)
 {
-    return loadGifConfig(name, info);
+    lock();
+    int index = findGif(name);
+    if (index >= 0)
+        info = _gifs[index];
+    unlock();
+    return index >= 0 && info.valid;
 }
 
-bool GifManager::getGifInfoByIndex(int index, GifInfo &info)
+bool GifManager::getGifInfoByIndex(int index, GifInfo &info, uint16_t *delays)
 {
-    if (index < 0 || index >= (int)_gifNames.size())
-    {
-        info.valid = false;
+    info.valid = false;
+    lock();
+    if (index >= 0 && index < (int)_gifs.size())
+        info = _gifs[index];
+    unlock();
+    if (!info.valid)
         return false;
+
+    if (delays && !loadFrameDelays(info, delays))
+    {
+        for (int i = 0; i < MAX_GIF_FRAMES; i++)
+            delays[i] = info.defaultDelay;
     }
-    return loadGifConfig(_gifNames[index], info);
+    return true;
 }
 
-bool GifManager::createGif(const String &name, int frameCount, int width, int height, uint16_t defaultDelay)
+bool GifManager::createGif(const char *name, int frameCount, int width, int height, uint16_t defaultDelay,
+                           const uint16_t *delays, bool original)
 {
-    snprintf(_pathBuf, sizeof(_pathBuf), "%s/%s", GIFS_ROOT, name.c_str());
+    if (_scanning)
+        return false;
+    lock();
+    bool full = findGif(name) < 0 && _gifs.size() >= MAX_GIFS;
+    unlock();
+    if (full)
+    {
+        Serial.printf("[GifManager] Library full (%d GIFs)\n", MAX_GIFS);
+        return false;
+    }
+
+    snprintf(_pathBuf, sizeof(_pathBuf), "%s/%s", GIFS_ROOT, name);
 
     if (!ensureDirectory(_pathBuf))
     {
@@ -221,36 +642,56 @@ bool GifManager::createGif(const String &name, int frameCount, int width, int he
         return false;
     }
 
+    // Original GIFs carry their own frames and delays; everything else gets a pack
+    snprintf(_pathBuf, sizeof(_pathBuf), "%s/%s/%s", GIFS_ROOT, name, GIF_PACK_FILE);
+    if (original)
+    {
+        SD.remove(_pathBuf);
+    }
+    else if (!FramePack::create(_pathBuf, frameCount, width, height, defaultDelay, delays))
+    {
+        return false;
+    }
+
     GifInfo info;
-    strlcpy(info.name, name.c_str(), sizeof(info.name));
+    memset(&info, 0, sizeof(info));
+    strlcpy(info.name, name, sizeof(info.name));
     info.frameCount = frameCount;
     info.width = width;
     info.height = height;
     info.defaultDelay = defaultDelay;
+    info.packed = !original;
+    info.original = original;
+    info.delaysOffset = original ? 0 : FramePack::entryOffset(0);
     info.valid = true;
 
+    // config.json stays as this GIF's own copy of the record, used only to rebuild the index
     if (!saveGifConfig(name, info))
     {
         return false;
     }
 
-    bool found = false;
-    for (const auto &n : _gifNames)
+    // Looked up again: the table may have changed during the SD work above
+    lock();
+    int index = findGif(name);
+    bool ok = true;
+    if (index >= 0)
     {
-        if (n == name)
-        {
-            found = true;
-            break;
-        }
+        _gifs[index] = info;
     }
-
-    if (!found)
+    else
     {
-        _gifNames.push_back(name);
-        saveOrder();
+        ok = _gifs.push_back(info);
+        if (ok)
+            rebuildIndex();
     }
+    if (ok)
+        markDirty();
+    unlock();
 
-    return true;
+    if (!ok)
+        Serial.printf("[GifManager] Library full, %s not added\n", name);
+    return ok;
 }
 
 bool GifManager::saveFrame(const String &gifName, int frameIndex, const uint8_t *data, size_t len)
@@ -300,9 +741,12 @@ bool GifManager::deleteDirectory(const String &path)
     return SD.rmdir(path);
 }
 
-bool GifManager::deleteGif(const String &name)
+bool GifManager::deleteGif(const char *name)
 {
-    snprintf(_pathBuf, sizeof(_pathBuf), "%s/%s", GIFS_ROOT, name.c_str());
+    if (_scanning)
+        return false;
+
+    snprintf(_pathBuf, sizeof(_pathBuf), "%s/%s", GIFS_ROOT, name);
 
     if (!deleteDirectory(_pathBuf))
     {
@@ -310,55 +754,201 @@ bool GifManager::deleteGif(const String &name)
         return false;
     }
 
-    for (auto it = _gifNames.begin(); it != _gifNames.end(); ++it)
+    lock();
+    int index = findGif(name);
+    if (index >= 0)
     {
-        if (*it == name)
-        {
-            _gifNames.erase(it);
-            saveOrder();
-            break;
-        }
+        _gifs.erase(index);
+        rebuildIndex();
+        markDirty();
     }
+    unlock();
 
     return true;
 }
 
-bool GifManager::reorderGifs(const std::vector<String> &names)
+bool GifManager::reorderGifs(const std::vector<const char *> &names)
 {
-    for (const auto &name : names)
+    if (_scanning)
+        return false;
+
+    // from[i] = current index of the record that moves to position i
+    lock();
+    int count = _gifs.size();
+    std::vector<int16_t> from;
+    std::vector<uint8_t> placed(count, 0);
+    from.reserve(count);
+    for (const char *name : names)
     {
-        bool found = false;
-        for (const auto &n : _gifNames)
+        int index = findGif(name);
+        if (index < 0)
         {
-            if (n == name)
-            {
-                found = true;
-                break;
-            }
+            unlock();
+            return false;
         }
-        if (!found)
+        if (!placed[index])
         {
-            return false;
+            placed[index] = 1;
+            from.push_back(index);
         }
     }
+    for (int i = 0; i < count; i++)
+    {
+        if (!placed[i])
+            from.push_back(i);
+    }
 
-    _gifNames = names;
-    return saveOrder();
+    // Apply the permutation in place, one cycle at a time
+    std::fill(placed.begin(), placed.end(), 0);
+    for (int start = 0; start < count; start++)
+    {
+        if (placed[start])
+            continue;
+        GifInfo first = _gifs[start];
+        int pos = start;
+        while (from[pos] != start)
+        {
+            _gifs[pos] = _gifs[from[pos]];
+            placed[pos] = 1;
+            pos = from[pos];
+        }
+        _gifs[pos] = first;
+        placed[pos] = 1;
+    }
+    rebuildIndex();
+    markDirty();
+    unlock();
+    return true;
 }
 
 bool GifManager::moveGif(int fromIndex, int toIndex)
 {
-    int size = _gifNames.size();
+    if (_scanning)
+        return false;
+
+    lock();
+    int size = _gifs.size();
     if (fromIndex < 0 || fromIndex >= size ||
         toIndex < 0 || toIndex >= size ||
         fromIndex == toIndex)
     {
+        unlock();
         return false;
     }
 
-    String temp = _gifNames[fromIndex];
-    _gifNames.erase(_gifNames.begin() + fromIndex);
-    _gifNames.insert(_gifNames.begin() + toIndex, temp);
+    GifInfo temp = _gifs[fromIndex];
+    _gifs.erase(fromIndex);
+    _gifs.insert(toIndex, temp); // can't fail: the slot erase freed is still allocated
+    rebuildIndex();
+    markDirty();
+    unlock();
+
+    return true;
+}
+
+// On-target comparison of the index against what refresh() did before it:
+// order.json plus SD.exists and a config.json parse per GIF. One config file
+// stands in for all of them; what matters is the open + parse per GIF.
+void GifManager::benchmark()
+{
+    if (LIBRARY_BENCH <= 0)
+        return;
+
+    static const int SIZES[] = {10, 100, 1000};
+    static const char *BENCH_INDEX = GIFS_ROOT "/.bench.bin";
+    static const char *BENCH_ORDER = GIFS_ROOT "/.bench.json";
+    static const char *BENCH_CONFIG = GIFS_ROOT "/.bench_cfg.json";
+
+    GifInfo sample;
+    memset(&sample, 0, sizeof(sample));
+    sample.frameCount = 60;
+    sample.width = CANVAS_WIDTH;
+    sample.height = CANVAS_HEIGHT;
+    sample.defaultDelay = 100;
+    sample.packed = true;
+    sample.delaysOffset = FramePack::entryOffset(0);
+    sample.valid = true;
+
+    File cfg = SD.open(BENCH_CONFIG, FILE_WRITE);
+    if (!cfg)
+        return;
+    JsonDocument cfgDoc;
+    cfgDoc["frameCount"] = 60;
+    cfgDoc["width"] = CANVAS_WIDTH;
+    cfgDoc["height"] = CANVAS_HEIGHT;
+    cfgDoc["defaultDelay"] = 100;
+    cfgDoc["packed"] = true;
+    serializeJson(cfgDoc, cfg);
+    cfg.close();
+
+    for (int n : SIZES)
+    {
+        {
+            GifTable gifs;
+            JsonDocument order;
+            JsonArray arr = order["order"].to<JsonArray>();
+            for (int i = 0; i < n; i++)
+            {
+                gifs.push_back(sample);
+                snprintf(gifs[i].name, sizeof(gifs[i].name), "gif%04d", i);
+                arr.add(gifs[i].name);
+            }
+            writeLibrary(BENCH_INDEX, gifs);
+            File f = SD.open(BENCH_ORDER, FILE_WRITE);
+            if (f)
+            {
+                serializeJson(order, f);
+                f.close();
+            }
+        }
+
+        uint32_t heapBefore = ESP.getFreeHeap();
+        uint32_t startUs = micros();
+        GifTable loaded;
+        loadLibrary(BENCH_INDEX, loaded);
+        uint32_t indexUs = micros() - startUs;
+        uint32_t indexHeap = heapBefore - ESP.getFreeHeap();
+        uint32_t indexBlock = ESP.getMaxAllocHeap();
+        loaded.release();
+
+        heapBefore = ESP.getFreeHeap();
+        startUs = micros();
+        {
+            std::vector<String> names;
+            File f = SD.open(BENCH_ORDER, FILE_READ);
+            JsonDocument order;
+            deserializeJson(order, f);
+            f.close();
+            for (JsonVariant v : order["order"].as<JsonArray>())
+            {
+                names.push_back(v.as<const char *>());
+                snprintf(_pathBuf, sizeof(_pathBuf), "%s/%s", GIFS_ROOT, names.back().c_str());
+                SD.exists(_pathBuf);
+            }
+            for (const auto &name : names)
+            {
+                File c = SD.open(BENCH_CONFIG, FILE_READ);
+                JsonDocument doc;
+                deserializeJson(doc, c);
+                c.close();
+                GifInfo info = sample;
+                strlcpy(info.name, name.c_str(), sizeof(info.name));
+                info.frameCount = doc["frameCount"] | 0;
+                loaded.push_back(info);
+            }
+        }
+        uint32_t jsonUs = micros() - startUs;
+        uint32_t jsonHeap = heapBefore - ESP.getFreeHeap();
+        uint32_t jsonBlock = ESP.getMaxAllocHeap();
+        loaded.release();
+
+        Serial.printf("[GifManager] %4d GIFs: index %7u us, %6u B held, largest block %u | "
+                      "JSON %8u us, %6u B held, largest block %u\n",
+                      n, (unsigned)indexUs, (unsigned)indexHeap, (unsigned)indexBlock,
+                      (unsigned)jsonUs, (unsigned)jsonHeap, (unsigned)jsonBlock);
+    }
 
-    return saveOrder();
+    SD.remove(BENCH_INDEX);
+    SD.remove(BENCH_ORDER);
+    SD.remove(BENCH_CONFIG);
 }
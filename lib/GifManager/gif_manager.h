@@ -6,46 +6,149 @@
 #include <vector>
 #include "config.h"
 
+#define LIBRARY_MAGIC 0x42494C48 // "HLIB"
+#define LIBRARY_VERSION 1
+
+// LIBRARY_FILE layout: LibraryHeader | GifInfo[count], in playback order
+struct LibraryHeader
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t recordSize; // sizeof(GifInfo)
+    uint32_t count;
+    uint32_t checksum; // FNV-1a over the records
+};
+
+// One library record, both in RAM and in LIBRARY_FILE. Ordered so it has no
+// padding; the index is read straight into the table.
 struct GifInfo
 {
-    char name[MAX_GIF_NAME_LEN + 1];
-    int frameCount;
-    int width;
-    int height;
+    uint32_t delaysOffset; // frame table in GIF_PACK_FILE, 0 when not packed
+    uint16_t frameCount;
+    uint16_t width;
+    uint16_t height;
     uint16_t defaultDelay;
+    char name[MAX_GIF_NAME_LEN + 1];
+    bool packed;
+    bool original; // played straight from GIF_ORIGINAL_FILE
     bool valid;
 };
+static_assert(sizeof(GifInfo) == 48, "GifInfo is the on-disk record; keep it free of padding");
+
+// Library records in fixed chunks of LIBRARY_GROW. A chunk never moves once
+// allocated, so growing the library copies nothing; shrinking keeps the chunks.
+class GifTable
+{
+public:
+    static const size_t CHUNK = LIBRARY_GROW;
+
+    GifTable() = default;
+    GifTable(const GifTable &) = delete;
+    GifTable &operator=(const GifTable &) = delete;
+    ~GifTable() { release(); }
+
+    size_t size() const { return _count; }
+    GifInfo &operator[](size_t i) { return _chunks[i / CHUNK][i % CHUNK]; }
+    const GifInfo &operator[](size_t i) const { return _chunks[i / CHUNK][i % CHUNK]; }
+
+    // false if the heap or MAX_GIFS runs out; new records are uninitialized
+    bool resize(size_t count);
+    bool push_back(const GifInfo &info) { return insert(_count, info); }
+    bool insert(size_t index, const GifInfo &info);
+    void erase(size_t index);
+    void clear() { _count = 0; }
+    void release(); // clears and frees every chunk
+    void swap(GifTable &other);
+
+private:
+    GifInfo *_chunks[(MAX_GIFS + CHUNK - 1) / CHUNK] = {};
+    size_t _count = 0;
+};
 
 class GifManager
 {
 public:
     GifManager();
 
-    bool begin();
+    // background: a missing index is rebuilt by a task instead of blocking boot
+    bool begin(bool background = false);
 
+    // Metadata comes from the table and never touches SD. delays, if given,
+    // is still read from the pack's frame table.
     int getGifCount();
-    String getGifName(int index);
-    bool getGifInfo(const String &name, GifInfo &info);
-    bool getGifInfoByIndex(int index, GifInfo &info);
+    // Copies the name out under the lock; false if index is out of range
+    bool getGifName(int index, char *out, size_t outSize);
+    bool getGifInfo(const char *name, GifInfo &info);
+    bool getGifInfoByIndex(int index, GifInfo &info, uint16_t *delays = nullptr);
+    int indexOf(const char *name); // -1 if absent
 
-    bool createGif(const String &name, int frameCount, int width, int height, uint16_t defaultDelay);
-    bool deleteGif(const String &name);
+    // Changes fail once the library holds MAX_GIFS, or while a scan is running
+    bool createGif(const char *name, int frameCount, int width, int height, uint16_t defaultDelay,
+                   const uint16_t *delays = nullptr, bool original = false);
+    bool deleteGif(const char *name);
     bool saveFrame(const String &gifName, int frameIndex, const uint8_t *data, size_t len);
     String getFramePath(const String &gifName, int frameIndex);
 
-    bool reorderGifs(const std::vector<String> &names);
+    // Listed GIFs first, in that order; any left out keep their relative order after them
+    bool reorderGifs(const std::vector<const char *> &names);
     bool moveGif(int fromIndex, int toIndex);
-    bool refresh();
+    // Loads LIBRARY_FILE, or rebuilds it from the GIF directories when it is
+    // missing or corrupt (boot)
+    bool refresh(bool background = false);
+    // A background rebuild is running; the table is empty until it finishes
+    bool isScanning() const { return _scanning; }
+    // Called from the scan task once its result is in the table
+    void setOnScanDone(void (*callback)()) { _onScanDone = callback; }
+
+    // Changes mark the library dirty; it is written LIBRARY_SAVE_DELAY_MS after
+    // the first one, so a burst of reorders costs one write. Main loop only.
+    void loop();
+    // Writes pending changes now (e.g. before a restart)
+    bool flush();
+    uint32_t saveRequests() const { return _saveRequests; }
+    uint32_t saveWrites() const { return _saveWrites; }
+
+    // Logs load time and heap use of the index vs the JSON files (LIBRARY_BENCH)
+    void benchmark();
 
 private:
-    std::vector<String> _gifNames;
+    // Read and written under _lock
+    GifTable _gifs;
+    // Open addressing by name hash, linear probing: each slot holds an index into
+    // _gifs or -1. At least twice as many slots as GIFs, so probes stay short.
+    std::vector<int16_t> _nameIndex;
+    SemaphoreHandle_t _lock;
+    SemaphoreHandle_t _saveLock; // one LIBRARY_TMP_FILE writer at a time; never taken under _lock
     char _pathBuf[64];
 
+    // Persistence bookkeeping; guarded by _lock
+    volatile bool _dirty;
+    unsigned long _dirtySince;
+    uint32_t _saveRequests; // changes that needed the library on SD
+    uint32_t _saveWrites;   // times it was actually written
+
+    volatile bool _scanning;
+    void (*_onScanDone)();
+
+    void lock() { if (_lock) xSemaphoreTake(_lock, portMAX_DELAY); }
+    void unlock() { if (_lock) xSemaphoreGive(_lock); }
+    int findGif(const char *name) const;
+    void rebuildIndex();
     bool ensureDirectory(const char *path);
-    bool loadOrder();
-    bool saveOrder();
+    bool loadLibrary(const char *path, GifTable &gifs);
+    bool writeLibrary(const char *path, const GifTable &gifs);
+    bool saveLibrary();
+    void markDirty();
+    bool rebuildLibrary(GifTable &gifs);
+    void adoptLibrary(GifTable &gifs, bool rebuilt, bool resave, uint32_t startMs);
+    bool startScan();
+    void runScan();
+    static void scanTask(void *param);
+    bool loadOrder(std::vector<String> &names);
     bool loadGifConfig(const String &name, GifInfo &info);
-    bool saveGifConfig(const String &name, const GifInfo &info);
+    bool loadPackInfo(const String &name, GifInfo &info);
+    bool loadFrameDelays(const GifInfo &info, uint16_t *delays);
+    bool saveGifConfig(const char *name, const GifInfo &info);
     bool deleteDirectory(const String &path);
 };
 
@@ -0,0 +1,148 @@
+#include "glyph_text.h"
+#include "pixel_kernels.h"
+
+GlyphText glyphText;
+
+// Calls fn(glyph, y, x, len) for every horizontal run of the rasterized font
+template <typename Fn>
+static void scanGlyphs(GFXcanvas1 &cell, char first, char last, Fn fn)
+{
+    for (int c = first; c <= last; c++)
+    {
+        cell.fillScreen(0);
+        cell.drawChar(0, 0, c, 1, 1, 1);
+        for (int y = 0; y < GlyphText::GLYPH_H; y++)
+        {
+            int x = 0;
+            while (x < GlyphText::GLYPH_W)
+            {
+                if (!cell.getPixel(x, y))
+                {
+                    x++;
+                    continue;
+                }
+                int end = x + 1;
+                while (end < GlyphText::GLYPH_W && cell.getPixel(end, y))
+                    end++;
+                fn(c - first, y, x, end - x);
+                x = end;
+            }
+        }
+    }
+}
+
+void GlyphText::begin()
+{
+    if (_runs)
+        return;
+
+    GFXcanvas1 cell(GLYPH_W, GLYPH_H);
+    if (!cell.getBuffer())
+        return;
+
+    // Count first so the run table is allocated exactly once
+    int total = 0;
+    scanGlyphs(cell, FIRST, LAST, [&](int, int, int, int)
+               { total++; });
+
+    _runs = (Run *)malloc(total * sizeof(Run));
+    if (!_runs)
+    {
+        Serial.println("[GlyphText] No memory for the glyph runs");
+        return;
+    }
+
+    int n = 0;
+    int glyph = -1;
+    scanGlyphs(cell, FIRST, LAST, [&](int g, int y, int x, int len)
+               {
+                   while (glyph < g)
+                       _start[++glyph] = n;
+                   _runs[n++] = {(uint8_t)y, (uint8_t)x, (uint8_t)len}; });
+    while (glyph < GLYPH_COUNT)
+        _start[++glyph] = n;
+
+    Serial.printf("[GlyphText] %d runs, %u bytes\n", total, (unsigned)(total * sizeof(Run)));
+}
+
+void GlyphText::fillRun(GFXcanvas16 *canvas, int x, int y, int w, int h, uint16_t color) const
+{
+    int cw = canvas->width();
+    int ch = canvas->height();
+    if (x < 0)
+    {
+        w += x;
+        x = 0;
+    }
+    if (y < 0)
+    {
+        h += y;
+        y = 0;
+    }
+    if (x + w > cw)
+        w = cw - x;
+    if (y + h > ch)
+        h = ch - y;
+    if (w <= 0 || h <= 0)
+        return;
+
+    uint16_t *row = canvas->getBuffer() + y * cw + x;
+    for (int j = 0; j < h; j++, row += cw)
+        pxFill(row, color, w);
+}
+
+int GlyphText::draw(GFXcanvas16 *canvas, int x, int y, const char *str, uint16_t color,
+                    uint8_t size) const
+{
+    if (!_runs || !canvas->getBuffer())
+    {
+        // No run table: fall back to the GFX path
+        canvas->setTextColor(color);
+        canvas->setTextSize(size);
+        canvas->setCursor(x, y);
+        canvas->print(str);
+        return x + width(str, size);
+    }
+
+    for (; *str; str++, x += GLYPH_W * size)
+    {
+        char c = *str;
+        if (c < FIRST || c > LAST)
+            continue;
+
+        int g = c - FIRST;
+        for (int i = _start[g]; i < _start[g + 1]; i++)
+        {
+            const Run &r = _runs[i];
+            fillRun(canvas, x + r.x * size, y + r.y * size, r.len * size, size, color);
+        }
+    }
+    return x;
+}
+
+void GlyphText::benchmark(GFXcanvas16 *canvas) const
+{
+    static const char *const SAMPLE = "Shake to roll!";
+    const int count = TEXT_BENCH_STRINGS;
+    if (count <= 0 || !canvas)
+        return;
+
+    uint32_t startUs = micros();
+    canvas->setTextColor(0xFFFF);
+    canvas->setTextSize(1);
+    for (int i = 0; i < count; i++)
+    {
+        canvas->setCursor(2, i & 0x7F);
+        canvas->print(SAMPLE);
+    }
+    uint32_t printUs = micros() - startUs;
+
+    startUs = micros();
+    for (int i = 0; i < count; i++)
+        draw(canvas, 2, i & 0x7F, SAMPLE, 0xFFFF);
+    uint32_t drawUs = micros() - startUs;
+
+    Serial.printf("[GlyphText] %d strings: print %.1f/ms, runs %.1f/ms\n", count,
+                  printUs ? count * 1000.0f / printUs : 0.0f,
+                  drawUs ? count * 1000.0f / drawUs : 0.0f);
+}
@@ -0,0 +1,50 @@
+#ifndef GLYPH_TEXT_H
+#define GLYPH_TEXT_H
+
+#include <Arduino.h>
+#include <Adafruit_GFX.h>
+#include "config.h"
+
+// Text for HUDs and the status strip. The classic 5x7 GFX font is rasterized once
+// into horizontal runs per glyph; drawing fills those runs straight into the
+// canvas buffer instead of going through drawPixel() for every set pixel.
+class GlyphText
+{
+public:
+    static const int GLYPH_W = 6; // advance, including the spacing column
+    static const int GLYPH_H = 8;
+
+    void begin();
+
+    // Top-left at (x, y), same placement as setCursor() + print(). Clipped to
+    // the canvas. Returns x past the last glyph.
+    int draw(GFXcanvas16 *canvas, int x, int y, const char *str, uint16_t color,
+             uint8_t size = 1) const;
+
+    // The font is fixed-pitch, so this never touches the glyphs
+    static int width(const char *str, uint8_t size = 1) { return strlen(str) * GLYPH_W * size; }
+
+    // Logs strings/ms for print() and draw() on the given canvas (TEXT_BENCH_STRINGS)
+    void benchmark(GFXcanvas16 *canvas) const;
+
+private:
+    static const char FIRST = 0x20;
+    static const char LAST = 0x7E;
+    static const int GLYPH_COUNT = LAST - FIRST + 1;
+
+    struct Run
+    {
+        uint8_t y;
+        uint8_t x;
+        uint8_t len;
+    };
+
+    Run *_runs = nullptr;
+    uint16_t _start[GLYPH_COUNT + 1] = {}; // glyph g owns _runs[_start[g], _start[g + 1])
+
+    void fillRun(GFXcanvas16 *canvas, int x, int y, int w, int h, uint16_t color) const;
+};
+
+extern GlyphText glyphText;
+
+#endif // GLYPH_TEXT_H
@@ -1,11 +1,14 @@
 #include "mpu.h"
+#include "perf_stats.h"
 #include <Wire.h>
 
 MPU mpu;
 
 MPU::MPU()
     : _offAx(0), _offAy(0), _offAz(0), _lastTilt(TILT_NEUTRAL), _lastPitch(PITCH_NEUTRAL),
-      _lastSwitchMs(0), _lastPitchMs(0), _lastShakeMs(0), _smoothedTilt(0)
+      _lastSwitchMs(0), _lastPitchMs(0), _lastShakeMs(0), _smoothedTilt(0),
+      _calSamples(0), _calRemaining(0), _calSumX(0), _calSumY(0), _calSumZ(0),
+      _calLastUs(0), _calStartMs(0)
 {
 }
 
@@ -24,26 +27,50 @@ void MPU::begin()
 }
 
 void MPU::calibrate(int samples)
+{
+    startCalibration(samples);
+    while (!calibrateStep())
+        delay(1);
+}
+
+void MPU::startCalibration(int samples)
 {
     Serial.printf("[MPU] Calibrating with %d samples...\n", samples);
 
-    float sumx = 0, sumy = 0, sumz = 0;
-    for (int i = 0; i < samples; i++)
-    {
-        float ax, ay, az;
-        readAccel(ax, ay, az);
-        sumx += ax;
-        sumy += ay;
-        sumz += az;
-        delay(2);
-    }
+    // Samples are raw readings, so drop any previous offsets
+    _offAx = _offAy = _offAz = 0;
+    _calSamples = samples;
+    _calRemaining = samples;
+    _calSumX = _calSumY = _calSumZ = 0;
+    _calLastUs = micros() - 2000;
+    _calStartMs = millis();
+}
+
+// One sample per call, at least 2 ms apart; true once the offsets are set
+bool MPU::calibrateStep()
+{
+    if (_calRemaining == 0)
+        return true;
+    if (micros() - _calLastUs < 2000)
+        return false;
+    _calLastUs = micros();
+
+    float ax, ay, az;
+    readAccel(ax, ay, az);
+    _calSumX += ax;
+    _calSumY += ay;
+    _calSumZ += az;
+    if (--_calRemaining > 0)
+        return false;
 
-    _offAx = sumx / samples;
-    _offAy = sumy / samples;
-    _offAz = sumz / samples - 1.0f;
+    _offAx = _calSumX / _calSamples;
+    _offAy = _calSumY / _calSamples;
+    _offAz = _calSumZ / _calSamples - 1.0f;
 
     Serial.printf("[MPU] Calibration done. Offsets: %.3f, %.3f, %.3f\n",
                   _offAx, _offAy, _offAz);
+    perfStats.bootPhase("calibration", _calStartMs);
+    return true;
 }
 
 void MPU::readAccel(float &ax, float &ay, float &az)
@@ -78,6 +105,9 @@ float MPU::readPitchDeg()
 
 int MPU::checkTiltChange()
 {
+    if (!isCalibrated())
+        return 0;
+
     float roll = readRollDeg();
     unsigned long now = millis();
 
@@ -116,6 +146,9 @@ int MPU::checkTiltChange()
 
 int MPU::checkPitchChange()
 {
+    if (!isCalibrated())
+        return 0;
+
     float pitch = readPitchDeg();
     unsigned long now = millis();
 
@@ -24,7 +24,12 @@ public:
     MPU();
 
     void begin();
-    void calibrate(int samples = 300);
+    void calibrate(int samples = MPU_CALIBRATION_SAMPLES);
+    // Non-blocking calibration: start, then call calibrateStep() from the main
+    // loop; tilt and pitch read neutral until it completes
+    void startCalibration(int samples = MPU_CALIBRATION_SAMPLES);
+    bool calibrateStep();
+    bool isCalibrated() const { return _calRemaining == 0; }
     int checkTiltChange();
     int checkPitchChange();
     bool checkShake();
@@ -40,6 +45,13 @@ private:
     unsigned long _lastShakeMs;
     float _smoothedTilt;
 
+    // Calibration in progress
+    int _calSamples;
+    int _calRemaining;
+    float _calSumX, _calSumY, _calSumZ;
+    uint32_t _calLastUs;
+    uint32_t _calStartMs;
+
     void readAccel(float &ax, float &ay, float &az);
     float readRollDeg();
     float readPitchDeg();
@@ -1,38 +1,52 @@
 #include "now_playing_app.h"
 #include "display.h"
-#include "frame_loader.h"
+#include "glyph_text.h"
+#include "pixel_kernels.h"
+#include "spi_bus.h"
 #include "config.h"
+#include <SD.h>
 
 NowPlayingApp nowPlayingApp;
 
-static const uint16_t COLOR_GRAY = 0x7BEF;
+const char *const NowPlayingApp::STRIP_NAMES[NowPlayingApp::STRIP_COUNT] = {"title", "artist"};
+
+static const uint16_t COLOR_GRAY = canvasColor(0x7BEF);
 
 NowPlayingApp::NowPlayingApp()
-    : _currentFrame(0), _nextFrame(1), _lastFrameTime(0), _needRedraw(true), _frameRequested(false)
+    : _art(nullptr), _band{0, 0, 0, 0}, _maxScroll(0), _shownOffset(-1), _scrollStart(0),
+      _reloadPending(false), _sceneLoaded(false), _needRedraw(true)
 {
     memset(&_info, 0, sizeof(_info));
-    _nextFramePath[0] = '\0';
+    memset(_strips, 0, sizeof(_strips));
 }
 
 void NowPlayingApp::onEnter()
 {
     Serial.println("[NowPlaying] Enter");
-    frameLoader.begin();
-    _currentFrame = 0;
-    _lastFrameTime = millis();
+    _reloadPending = _info.framesReady;
     _needRedraw = true;
-    _frameRequested = false;
 }
 
 void NowPlayingApp::onExit()
 {
     Serial.println("[NowPlaying] Exit");
+    freeScene();
 }
 
 void NowPlayingApp::loop()
 {
-    if (!_info.framesReady || _info.frameCount <= 0)
+    if (_reloadPending)
+    {
+        _reloadPending = false;
+        freeScene();
+        loadScene();
+        _needRedraw = true;
+    }
+
+    if (!_info.framesReady || !_sceneLoaded)
     {
+        if (_sceneLoaded)
+            freeScene();
         if (_needRedraw)
         {
             _needRedraw = false;
@@ -42,53 +56,187 @@ void NowPlayingApp::loop()
         return;
     }
 
-    unsigned long now = millis();
-    unsigned long frameDelay = NP_FRAME_DELAY_MS;
-    if (_currentFrame == 0 || _currentFrame == _info.frameCount - 1)
-        frameDelay *= 5;
+    int offset = scrollOffset(millis());
+    if (!_needRedraw && offset == _shownOffset)
+        return;
+
+    // The art never changes, so after the first push only the text band goes out
+    GFXcanvas16 *canvas = display.acquireDraw();
+    if (!canvas)
+        return;
+    display.copyToBackBuffer(_art);
+    drawStrips(canvas->getBuffer(), offset);
+    display.publish(_needRedraw ? nullptr : &_band);
+
+    _needRedraw = false;
+    _shownOffset = offset;
+}
+
+// Rests at each end for NP_SCROLL_PAUSE_MS, travels at NP_SCROLL_PX_PER_SEC
+int NowPlayingApp::scrollOffset(unsigned long now) const
+{
+    if (_maxScroll <= 0)
+        return 0;
+
+    uint32_t travelMs = (uint32_t)_maxScroll * 1000 / NP_SCROLL_PX_PER_SEC;
+    uint32_t t = (now - _scrollStart) % (2 * NP_SCROLL_PAUSE_MS + travelMs);
+    if (t < NP_SCROLL_PAUSE_MS)
+        return 0;
+    t -= NP_SCROLL_PAUSE_MS;
+    if (t >= travelMs)
+        return _maxScroll;
+    return t * NP_SCROLL_PX_PER_SEC / 1000;
+}
 
-    if (!_frameRequested)
+void NowPlayingApp::drawStrips(uint16_t *fb, int offset)
+{
+    for (int i = 0; i < STRIP_COUNT; i++)
     {
-        snprintf(_nextFramePath, sizeof(_nextFramePath), "%s/%d.bmp", NP_DIR, _nextFrame);
-        frameLoader.requestLoad(_nextFramePath);
-        _frameRequested = true;
+        const Strip &s = _strips[i];
+        if (!s.alpha)
+            continue;
+
+        int left = s.hdr.x - min(offset, s.scroll);
+        int x0 = max(max((int)s.hdr.clipX, left), 0);
+        int x1 = min(min(s.hdr.clipX + s.hdr.clipW, left + s.hdr.w), CANVAS_WIDTH);
+        if (x1 <= x0)
+            continue;
+
+        for (int r = 0; r < s.hdr.h; r++)
+        {
+            int y = s.hdr.y + r;
+            if (y < 0 || y >= CANVAS_HEIGHT)
+                continue;
+            pxBlendAlpha(fb + y * CANVAS_WIDTH + x0, s.alpha + r * s.hdr.w + (x0 - left), s.hdr.color,
+                         x1 - x0);
+        }
     }
+}
 
-    if (frameLoader.isLoaded() && now - _lastFrameTime >= frameDelay)
+bool NowPlayingApp::loadStrip(const char *stripName, Strip &strip)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "%s/%s.bin", NP_DIR, stripName);
+
+    NpStripHeader &hdr = strip.hdr;
+    size_t bytes = 0;
+    bool ok;
     {
-        _lastFrameTime = now;
-        frameLoader.consumeLoaded();
-        display.swapAndRender();
-        _currentFrame = _nextFrame;
-        _nextFrame = (_nextFrame + 1) % _info.frameCount;
-        _frameRequested = false;
+        // The bus is held for the file only; alpha conversion below runs without it
+        SpiBusScope bus(SPI_CLIENT_LOADER);
+        File f = SD.open(path, FILE_READ);
+        if (!f)
+            return false;
+
+        ok = f.read((uint8_t *)&hdr, sizeof(hdr)) == sizeof(hdr) && hdr.magic == NP_STRIP_MAGIC &&
+             hdr.w > 0 && hdr.h > 0 && hdr.clipW > 0;
+        if (ok)
+        {
+            bytes = (size_t)hdr.w * hdr.h;
+            ok = bytes <= NP_STRIP_MAX_BYTES;
+        }
+        if (ok)
+        {
+            strip.alpha = (uint8_t *)malloc(bytes);
+            ok = strip.alpha && f.read(strip.alpha, bytes) == bytes;
+        }
+        f.close();
     }
+
+    if (!ok)
+    {
+        Serial.printf("[NowPlaying] Bad strip: %s\n", path);
+        free(strip.alpha);
+        strip.alpha = nullptr;
+        return false;
+    }
+
+    for (size_t i = 0; i < bytes; i++)
+        strip.alpha[i] = (strip.alpha[i] + 4) >> 3;
+    hdr.color = canvasColor(hdr.color);
+    strip.scroll = max(0, hdr.x + (int)hdr.w - (hdr.clipX + hdr.clipW));
+    return true;
+}
+
+bool NowPlayingApp::loadScene()
+{
+    _art = (uint16_t *)malloc(CANVAS_WIDTH * CANVAS_HEIGHT * 2);
+    if (!_art)
+    {
+        Serial.println("[NowPlaying] No memory for the art");
+        return false;
+    }
+
+    char path[64];
+    snprintf(path, sizeof(path), "%s/0.bmp", NP_DIR);
+
+    bool ok = display.decodeBmpToCanvas(path, _art, SPI_CLIENT_LOADER);
+    int y0 = CANVAS_HEIGHT, y1 = 0, x0 = CANVAS_WIDTH, x1 = 0;
+    _maxScroll = 0;
+    for (int i = 0; ok && i < STRIP_COUNT; i++)
+    {
+        Strip &s = _strips[i];
+        if (!loadStrip(STRIP_NAMES[i], s))
+            continue;
+        _maxScroll = max(_maxScroll, s.scroll);
+        y0 = min(y0, (int)s.hdr.y);
+        y1 = max(y1, s.hdr.y + s.hdr.h);
+        x0 = min(x0, (int)s.hdr.clipX);
+        x1 = max(x1, s.hdr.clipX + s.hdr.clipW);
+    }
+
+    if (!ok)
+    {
+        freeScene();
+        return false;
+    }
+
+    y0 = max(y0, 0);
+    x0 = max(x0, 0);
+    y1 = min(y1, CANVAS_HEIGHT);
+    x1 = min(x1, CANVAS_WIDTH);
+    _band = (y1 > y0 && x1 > x0) ? DirtyRect{(int16_t)x0, (int16_t)y0, (int16_t)(x1 - x0), (int16_t)(y1 - y0)}
+                                 : DirtyRect{0, 0, 0, 0};
+
+    _sceneLoaded = true;
+    _shownOffset = -1;
+    _scrollStart = millis();
+    Serial.printf("[NowPlaying] Scene loaded, scroll %d px\n", _maxScroll);
+    return true;
+}
+
+void NowPlayingApp::freeScene()
+{
+    for (int i = 0; i < STRIP_COUNT; i++)
+    {
+        free(_strips[i].alpha);
+        _strips[i].alpha = nullptr;
+    }
+    free(_art);
+    _art = nullptr;
+    _sceneLoaded = false;
+    _needRedraw = true;
 }
 
-void NowPlayingApp::updateTrack(const char *title, const char *artist, int frameCount)
+void NowPlayingApp::updateTrack(const char *title, const char *artist)
 {
     strncpy(_info.title, title, sizeof(_info.title) - 1);
     _info.title[sizeof(_info.title) - 1] = '\0';
     strncpy(_info.artist, artist, sizeof(_info.artist) - 1);
     _info.artist[sizeof(_info.artist) - 1] = '\0';
-    _info.frameCount = frameCount;
     _info.framesReady = false;
     _info.lastUpdate = millis();
 
-    _currentFrame = 0;
     _needRedraw = true;
 
-    Serial.printf("[NowPlaying] Track: %s - %s (%d frames)\n",
-                  _info.artist, _info.title, frameCount);
+    Serial.printf("[NowPlaying] Track: %s - %s\n", _info.artist, _info.title);
 }
 
 void NowPlayingApp::setFramesReady()
 {
     _info.framesReady = true;
-    _currentFrame = 0;
-    _lastFrameTime = millis();
-    _frameRequested = false;
-    Serial.printf("[NowPlaying] Frames ready (%d)\n", _info.frameCount);
+    _reloadPending = true;
+    Serial.println("[NowPlaying] Frames ready");
 }
 
 void NowPlayingApp::renderIdle()
@@ -99,16 +247,9 @@ void NowPlayingApp::renderIdle()
 
     display.clearBackBuffer();
 
-    canvas->setTextSize(1);
-    canvas->setTextColor(COLOR_GRAY);
-
     const char *header = "Now Playing";
-    int hw = strlen(header) * 6;
-    canvas->setCursor((CANVAS_WIDTH - hw) / 2, 35);
-    canvas->print(header);
+    glyphText.draw(canvas, (CANVAS_WIDTH - GlyphText::width(header)) / 2, 35, header, COLOR_GRAY);
 
     const char *msg = "Waiting for music...";
-    int mw = strlen(msg) * 6;
-    canvas->setCursor((CANVAS_WIDTH - mw) / 2, 55);
-    canvas->print(msg);
+    glyphText.draw(canvas, (CANVAS_WIDTH - GlyphText::width(msg)) / 2, 55, msg, COLOR_GRAY);
 }
@@ -2,19 +2,43 @@
 #define NOW_PLAYING_APP_H
 
 #include "app.h"
+#include "display.h"
 
 struct NowPlayingInfo
 {
     char title[64];
     char artist[48];
-    int frameCount;
     bool framesReady;
     unsigned long lastUpdate;
 };
 
+// Marquee text line uploaded by the companion as NP_DIR/<name>.bin:
+//   NpStripHeader | w * h coverage bytes (0-255), rows top to bottom
+// (x, y) is where the strip sits before it scrolls; only columns inside
+// [clipX, clipX + clipW) are drawn.
+#define NP_STRIP_MAGIC 0x534E // "NS"
+
+struct __attribute__((packed)) NpStripHeader
+{
+    uint16_t magic;
+    int16_t x;
+    int16_t y;
+    uint16_t w;
+    uint16_t h;
+    uint16_t color; // RGB565
+    int16_t clipX;
+    int16_t clipW;
+};
+
+// Album art and the dimmed text bar arrive once as NP_DIR/0.bmp; title and
+// artist come as alpha strips. The art stays in RAM and only the text band is
+// recomposed and pushed as the strips scroll, one pixel at a time.
 class NowPlayingApp : public App
 {
 public:
+    static const int STRIP_COUNT = 2;
+    static const char *const STRIP_NAMES[STRIP_COUNT]; // "title", "artist"
+
     NowPlayingApp();
 
     void onEnter() override;
@@ -22,20 +46,35 @@ public:
     void loop() override;
     const char *name() const override { return "NowPlaying"; }
 
-    void updateTrack(const char *title, const char *artist, int frameCount);
+    void updateTrack(const char *title, const char *artist);
     void setFramesReady();
     const NowPlayingInfo &getInfo() const { return _info; }
 
 private:
+    struct Strip
+    {
+        uint8_t *alpha; // w * h, scaled to 0..32
+        NpStripHeader hdr;
+        int scroll; // how far the text travels
+    };
+
     NowPlayingInfo _info;
-    int _currentFrame;
-    int _nextFrame;
-    unsigned long _lastFrameTime;
+    uint16_t *_art; // full canvas with the empty text bar
+    Strip _strips[STRIP_COUNT];
+    DirtyRect _band; // rows the strips cover
+    int _maxScroll;
+    int _shownOffset;
+    unsigned long _scrollStart;
+    volatile bool _reloadPending;
+    bool _sceneLoaded;
     bool _needRedraw;
-    bool _frameRequested;
-    char _nextFramePath[32];
 
     void renderIdle();
+    bool loadScene();
+    bool loadStrip(const char *stripName, Strip &strip);
+    void freeScene();
+    int scrollOffset(unsigned long now) const;
+    void drawStrips(uint16_t *fb, int offset);
 };
 
 extern NowPlayingApp nowPlayingApp;
@@ -0,0 +1,96 @@
+#include "perf_stats.h"
+
+PerfStats perfStats;
+
+static const char *const PROBE_NAMES[PERF_PROBE_COUNT] = {
+    "sdOpen", "sdRead", "pixelConvert", "status", "spiPush", "appUpdate"};
+
+void PerfStats::begin()
+{
+    _cyclesPerUs = ESP.getCpuFreqMHz();
+    if (_cyclesPerUs == 0)
+        _cyclesPerUs = 240;
+    _resetMs = millis();
+}
+
+void IRAM_ATTR PerfStats::add(PerfProbe probe, uint32_t cycles)
+{
+    uint32_t us = cycles / _cyclesPerUs;
+    int bucket = (us < 2) ? 0 : 31 - __builtin_clz(us);
+    if (bucket >= PERF_BUCKETS)
+        bucket = PERF_BUCKETS - 1;
+
+    PerfHistogram &h = _hist[probe];
+    portENTER_CRITICAL(&_histMux);
+    uint32_t generation = _generation;
+    if (h.generation != generation)
+    {
+        memset(&h, 0, sizeof(h));
+        h.generation = generation;
+    }
+
+    h.count++;
+    h.totalUs += us;
+    if (us > h.maxUs)
+        h.maxUs = us;
+    h.buckets[bucket]++;
+    portEXIT_CRITICAL(&_histMux);
+}
+
+// Writers notice the new generation and clear the histogram on their next
+// sample, so reset never waits on the lock
+void PerfStats::reset()
+{
+    _generation = _generation + 1;
+    _resetMs = millis();
+}
+
+void PerfStats::bootPhase(const char *name, uint32_t startMs)
+{
+    uint32_t endMs = millis();
+    portENTER_CRITICAL(&_bootMux);
+    if (_bootCount < BOOT_PHASE_MAX)
+        _boot[_bootCount++] = {name, startMs, endMs - startMs};
+    portEXIT_CRITICAL(&_bootMux);
+    Serial.printf("[Boot] %-12s %5u ms (done at %u ms)\n", name,
+                  (unsigned)(endMs - startMs), (unsigned)endMs);
+}
+
+void PerfStats::toJson(JsonObject obj) const
+{
+    obj["enabled"] = PERF_STATS != 0;
+    obj["sinceMs"] = millis() - _resetMs;
+    obj["cpuMhz"] = _cyclesPerUs;
+
+    JsonObject probes = obj["probes"].to<JsonObject>();
+    for (int i = 0; i < PERF_PROBE_COUNT; i++)
+    {
+        portENTER_CRITICAL(&_histMux);
+        PerfHistogram h = _hist[i];
+        portEXIT_CRITICAL(&_histMux);
+        if (h.generation != _generation)
+            memset(&h, 0, sizeof(h));
+
+        JsonObject p = probes[PROBE_NAMES[i]].to<JsonObject>();
+        p["count"] = h.count;
+        p["avgUs"] = h.count ? (uint32_t)(h.totalUs / h.count) : 0;
+        p["maxUs"] = h.maxUs;
+        JsonArray buckets = p["buckets"].to<JsonArray>();
+        for (int b = 0; b < PERF_BUCKETS; b++)
+            buckets.add(h.buckets[b]);
+    }
+
+    // Entries are written once and never change, so the count is all that needs the lock
+    portENTER_CRITICAL(&_bootMux);
+    int bootCount = _bootCount;
+    portEXIT_CRITICAL(&_bootMux);
+
+    JsonArray boot = obj["boot"].to<JsonArray>();
+    for (int i = 0; i < bootCount; i++)
+    {
+        JsonObject b = boot.add<JsonObject>();
+        b["phase"] = _boot[i].name;
+        b["startMs"] = _boot[i].startMs;
+        b["ms"] = _boot[i].ms;
+    }
+}
@@ -0,0 +1,91 @@
+#ifndef PERF_STATS_H
+#define PERF_STATS_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "config.h"
+
+enum PerfProbe : uint8_t
+{
+    PERF_SD_OPEN,       // opening a frame source
+    PERF_SD_READ,       // pixel data reads
+    PERF_PIXEL_CONVERT, // byte order, 888 and palette expansion
+    PERF_STATUS,        // status strip redraw and push
+    PERF_SPI_PUSH,      // one canvas push to the panel
+    PERF_APP_UPDATE,    // one App::loop()
+    PERF_PROBE_COUNT
+};
+
+// Log2 buckets of microseconds: bucket 0 is < 2 us, bucket b covers
+// [2^b, 2^(b+1)) and the last one collects everything longer
+static const int PERF_BUCKETS = 16;
+
+struct PerfHistogram
+{
+    uint32_t count;
+    uint32_t maxUs;
+    uint64_t totalUs;
+    uint32_t buckets[PERF_BUCKETS];
+    uint32_t generation; // stale after a reset until the next sample
+};
+
+// One step of the boot timeline; times are millis() since reset
+struct BootPhase
+{
+    const char *name; // string literal
+    uint32_t startMs;
+    uint32_t ms;
+};
+
+// Always-on timing from the CPU cycle counter. Recording is a subtraction and
+// a few increments under a spinlock: SD and pixel probes are fed from both
+// cores (FrameLoader, NowPlaying, web previews). The cycle counter is per core,
+// which is fine as long as a probe starts and stops on one task.
+class PerfStats
+{
+public:
+    void begin();
+
+    static uint32_t now() { return ESP.getCycleCount(); }
+    void record(PerfProbe probe, uint32_t startCycles)
+    {
+        if (PERF_STATS)
+            add(probe, ESP.getCycleCount() - startCycles);
+    }
+
+    // Clears every histogram; safe to call from any task
+    void reset();
+
+    // Logs and keeps a boot phase that ran from startMs until now. Any task may
+    // record one; background phases land whenever they finish. reset() keeps them.
+    void bootPhase(const char *name, uint32_t startMs);
+    void toJson(JsonObject obj) const;
+
+private:
+    PerfHistogram _hist[PERF_PROBE_COUNT] = {};
+    volatile uint32_t _generation = 1;
+    uint32_t _cyclesPerUs = 240;
+    unsigned long _resetMs = 0;
+    BootPhase _boot[BOOT_PHASE_MAX] = {};
+    int _bootCount = 0;
+    mutable portMUX_TYPE _bootMux = portMUX_INITIALIZER_UNLOCKED;
+    mutable portMUX_TYPE _histMux = portMUX_INITIALIZER_UNLOCKED;
+
+    void add(PerfProbe probe, uint32_t cycles);
+};
+
+extern PerfStats perfStats;
+
+// Records the lifetime of the scope into a probe
+class PerfScope
+{
+public:
+    explicit PerfScope(PerfProbe probe) : _probe(probe), _start(PerfStats::now()) {}
+    ~PerfScope() { perfStats.record(_probe, _start); }
+
+private:
+    PerfProbe _probe;
+    uint32_t _start;
+};
+
+#endif // PERF_STATS_H
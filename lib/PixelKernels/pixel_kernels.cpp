@@ -0,0 +1,291 @@
+#include "pixel_kernels.h"
+#include "config.h"
+
+static inline bool aligned(const void *p)
+{
+    return ((uintptr_t)p & 3) == 0;
+}
+
+static inline uint16_t rgb565(const uint8_t *bgr)
+{
+    uint16_t c = ((bgr[2] & 0xF8) << 8) | ((bgr[1] & 0xFC) << 3) | (bgr[0] >> 3);
+    return CANVAS_BIG_ENDIAN ? (uint16_t)((c << 8) | (c >> 8)) : c;
+}
+
+#if CANVAS_BIG_ENDIAN
+// Panel byte order: green's low bit has to cross from the low byte to the high one
+static inline uint32_t dim2(uint32_t w)
+{
+    return ((w >> 1) & 0x6F7B6F7B) | ((w & 0x00010001) << 15);
+}
+#else
+static inline uint32_t dim2(uint32_t w)
+{
+    return (w >> 1) & 0x7BEF7BEF;
+}
+#endif
+
+static inline uint16_t dim1(uint16_t p)
+{
+    return dim2(p);
+}
+
+void IRAM_ATTR pxFill(uint16_t *dst, uint16_t color, int n)
+{
+    if (n > 0 && !aligned(dst))
+    {
+        *dst++ = color;
+        n--;
+    }
+
+    uint32_t pair = color | ((uint32_t)color << 16);
+    uint32_t *d = (uint32_t *)dst;
+    int words = n >> 1;
+    int i = 0;
+    for (; i + 4 <= words; i += 4)
+    {
+        d[i] = pair;
+        d[i + 1] = pair;
+        d[i + 2] = pair;
+        d[i + 3] = pair;
+    }
+    for (; i < words; i++)
+        d[i] = pair;
+
+    if (n & 1)
+        dst[n - 1] = color;
+}
+
+void IRAM_ATTR pxCopy(uint16_t *dst, const uint16_t *src, int n)
+{
+    if (aligned(dst) != aligned(src))
+    {
+        memcpy(dst, src, n * 2);
+        return;
+    }
+    if (n > 0 && !aligned(dst))
+    {
+        *dst++ = *src++;
+        n--;
+    }
+
+    uint32_t *d = (uint32_t *)dst;
+    const uint32_t *s = (const uint32_t *)src;
+    int words = n >> 1;
+    int i = 0;
+    for (; i + 4 <= words; i += 4)
+    {
+        uint32_t a = s[i], b = s[i + 1], c = s[i + 2], e = s[i + 3];
+        d[i] = a;
+        d[i + 1] = b;
+        d[i + 2] = c;
+        d[i + 3] = e;
+    }
+    for (; i < words; i++)
+        d[i] = s[i];
+
+    if (n & 1)
+        dst[n - 1] = src[n - 1];
+}
+
+void IRAM_ATTR pxDim(uint16_t *dst, const uint16_t *src, int n)
+{
+    if (aligned(dst) != aligned(src))
+    {
+        for (int i = 0; i < n; i++)
+            dst[i] = dim1(src[i]);
+        return;
+    }
+    if (n > 0 && !aligned(dst))
+    {
+        *dst++ = dim1(*src++);
+        n--;
+    }
+
+    uint32_t *d = (uint32_t *)dst;
+    const uint32_t *s = (const uint32_t *)src;
+    int words = n >> 1;
+    for (int i = 0; i < words; i++)
+        d[i] = dim2(s[i]);
+
+    if (n & 1)
+        dst[n - 1] = dim1(src[n - 1]);
+}
+
+void IRAM_ATTR pxBlendKeyed(uint16_t *dst, const uint16_t *src, const uint16_t *key, int n)
+{
+    if (aligned(dst) != aligned(src) || aligned(dst) != aligned(key))
+    {
+        for (int i = 0; i < n; i++)
+            dst[i] = key[i] ? key[i] : (dim1(src[i]));
+        return;
+    }
+    if (n > 0 && !aligned(dst))
+    {
+        *dst++ = *key ? *key : dim1(*src);
+        src++;
+        key++;
+        n--;
+    }
+
+    uint32_t *d = (uint32_t *)dst;
+    const uint32_t *s = (const uint32_t *)src;
+    const uint32_t *k = (const uint32_t *)key;
+    int words = n >> 1;
+    for (int i = 0; i < words; i++)
+    {
+        uint32_t kw = k[i];
+        if (kw == 0)
+        {
+            d[i] = dim2(s[i]); // the common case: no text over either pixel
+            continue;
+        }
+        uint32_t mask = ((kw & 0xFFFF) ? 0xFFFF : 0) | ((kw >> 16) ? 0xFFFF0000 : 0);
+        d[i] = (kw & mask) | (dim2(s[i]) & ~mask);
+    }
+
+    if (n & 1)
+        dst[n - 1] = key[n - 1] ? key[n - 1] : (dim1(src[n - 1]));
+}
+
+// Spreads R, G and B apart so all three blend in one 32-bit multiply
+static inline uint32_t spread(uint16_t c)
+{
+    if (CANVAS_BIG_ENDIAN)
+        c = (c << 8) | (c >> 8);
+    return (c | ((uint32_t)c << 16)) & 0x07E0F81F;
+}
+
+static inline uint16_t unspread(uint32_t v)
+{
+    uint16_t c = (v & 0xF81F) | ((v >> 16) & 0x07E0);
+    return CANVAS_BIG_ENDIAN ? (uint16_t)((c << 8) | (c >> 8)) : c;
+}
+
+void IRAM_ATTR pxBlendAlpha(uint16_t *dst, const uint8_t *alpha, uint16_t color, int n)
+{
+    uint32_t fg = spread(color);
+    for (int i = 0; i < n; i++)
+    {
+        uint32_t a = alpha[i];
+        if (a == 0)
+            continue;
+        if (a >= 32)
+        {
+            dst[i] = color;
+            continue;
+        }
+        uint32_t bg = spread(dst[i]);
+        dst[i] = unspread(((fg * a + bg * (32 - a)) >> 5) & 0x07E0F81F);
+    }
+}
+
+void IRAM_ATTR pxConvert888(uint16_t *dst, const uint8_t *src, int n)
+{
+    if (n > 0 && !aligned(dst))
+    {
+        *dst++ = rgb565(src);
+        src += 3;
+        n--;
+    }
+
+    // Two pixels from 6 source bytes per store
+    uint32_t *d = (uint32_t *)dst;
+    int words = n >> 1;
+    for (int i = 0; i < words; i++, src += 6)
+        d[i] = rgb565(src) | ((uint32_t)rgb565(src + 3) << 16);
+
+    if (n & 1)
+        dst[n - 1] = rgb565(src);
+}
+
+void IRAM_ATTR pxByteSwap(uint16_t *dst, const uint16_t *src, int n)
+{
+    if (aligned(dst) != aligned(src))
+    {
+        for (int i = 0; i < n; i++)
+            dst[i] = (src[i] << 8) | (src[i] >> 8);
+        return;
+    }
+    if (n > 0 && !aligned(dst))
+    {
+        *dst = (*src << 8) | (*src >> 8);
+        dst++;
+        src++;
+        n--;
+    }
+
+    uint32_t *d = (uint32_t *)dst;
+    const uint32_t *s = (const uint32_t *)src;
+    int words = n >> 1;
+    for (int i = 0; i < words; i++)
+    {
+        uint32_t w = s[i];
+        d[i] = ((w & 0x00FF00FF) << 8) | ((w >> 8) & 0x00FF00FF);
+    }
+
+    if (n & 1)
+        dst[n - 1] = (src[n - 1] << 8) | (src[n - 1] >> 8);
+}
+
+// ---------------------------------------------------------------------------
+// On-target benchmark: one canvas row per call, PIXEL_BENCH_ROWS calls
+
+static uint32_t benchUs(void (*fn)(uint16_t *, const uint16_t *, const uint8_t *, const uint16_t *),
+                        uint16_t *dst, const uint16_t *src, const uint8_t *bgr, const uint16_t *key)
+{
+    uint32_t start = micros();
+    for (int i = 0; i < PIXEL_BENCH_ROWS; i++)
+        fn(dst, src, bgr, key);
+    return micros() - start;
+}
+
+static void logBench(const char *name, uint32_t scalarUs, uint32_t kernelUs)
+{
+    float pixels = (float)PIXEL_BENCH_ROWS * CANVAS_WIDTH;
+    Serial.printf("[PixelKernels] %-8s scalar %6.1f  kernel %6.1f Mpx/s\n", name,
+                  scalarUs ? pixels / scalarUs : 0.0f, kernelUs ? pixels / kernelUs : 0.0f);
+}
+
+#define BENCH_PAIR(name, scalarBody, kernelCall)                                                \
+    logBench(name,                                                                              \
+             benchUs([](uint16_t *d, const uint16_t *s, const uint8_t *b, const uint16_t *k)    \
+                     { for (int i = 0; i < CANVAS_WIDTH; i++) { scalarBody; } },                \
+                     dst, src, bgr, key),                                                       \
+             benchUs([](uint16_t *d, const uint16_t *s, const uint8_t *b, const uint16_t *k)    \
+                     { kernelCall; },                                                           \
+                     dst, src, bgr, key))
+
+void pxBenchmark()
+{
+    if (PIXEL_BENCH_ROWS <= 0)
+        return;
+
+    uint16_t *dst = (uint16_t *)malloc(CANVAS_WIDTH * 2);
+    uint16_t *src = (uint16_t *)malloc(CANVAS_WIDTH * 2);
+    uint16_t *key = (uint16_t *)malloc(CANVAS_WIDTH * 2);
+    uint8_t *bgr = (uint8_t *)malloc(CANVAS_WIDTH * 3);
+    if (dst && src && key && bgr)
+    {
+        for (int i = 0; i < CANVAS_WIDTH; i++)
+        {
+            src[i] = i * 0x0821;
+            key[i] = (i & 8) ? 0xFFFF : 0;
+        }
+        for (int i = 0; i < CANVAS_WIDTH * 3; i++)
+            bgr[i] = i;
+
+        // volatile stores keep the scalar loops from being turned into memset/memcpy
+        BENCH_PAIR("fill", ((volatile uint16_t *)d)[i] = 0x0019, pxFill(d, 0x0019, CANVAS_WIDTH));
+        BENCH_PAIR("copy", ((volatile uint16_t *)d)[i] = s[i], pxCopy(d, s, CANVAS_WIDTH));
+        BENCH_PAIR("dim", ((volatile uint16_t *)d)[i] = (s[i] >> 1) & 0x7BEF, pxDim(d, s, CANVAS_WIDTH));
+        BENCH_PAIR("blend", ((volatile uint16_t *)d)[i] = k[i] ? k[i] : ((s[i] >> 1) & 0x7BEF),
+                   pxBlendKeyed(d, s, k, CANVAS_WIDTH));
+        BENCH_PAIR("888", ((volatile uint16_t *)d)[i] = rgb565(b + i * 3), pxConvert888(d, b, CANVAS_WIDTH));
+        BENCH_PAIR("swap", ((volatile uint16_t *)d)[i] = (s[i] << 8) | (s[i] >> 8), pxByteSwap(d, s, CANVAS_WIDTH));
+    }
+    free(dst);
+    free(src);
+    free(key);
+    free(bgr);
+}
@@ -0,0 +1,30 @@
+#ifndef PIXEL_KERNELS_H
+#define PIXEL_KERNELS_H
+
+#include <Arduino.h>
+
+// RGB565 row kernels working on two pixels per 32-bit word. Each one handles
+// an odd leading or trailing pixel itself; when the pointers disagree on
+// 4-byte alignment they fall back to one pixel at a time. Lengths are in
+// pixels, in canvas byte order (CANVAS_BIG_ENDIAN). The hot ones live in IRAM
+// so flash cache misses don't stall them.
+
+// dst[i] = color
+void pxFill(uint16_t *dst, uint16_t color, int n);
+// dst[i] = src[i]
+void pxCopy(uint16_t *dst, const uint16_t *src, int n);
+// dst[i] = src[i] at half brightness (dst may equal src)
+void pxDim(uint16_t *dst, const uint16_t *src, int n);
+// dst[i] = key[i] ? key[i] : src[i] at half brightness; 0 in key is transparent
+void pxBlendKeyed(uint16_t *dst, const uint16_t *src, const uint16_t *key, int n);
+// dst[i] = color over dst[i] with coverage alpha[i] in 0..32 (anti-aliased text)
+void pxBlendAlpha(uint16_t *dst, const uint8_t *alpha, uint16_t color, int n);
+// dst[i] = RGB565 of the BGR triple at src + 3 * i (BMP byte order)
+void pxConvert888(uint16_t *dst, const uint8_t *src, int n);
+// dst[i] = src[i] with its bytes swapped (dst may equal src)
+void pxByteSwap(uint16_t *dst, const uint16_t *src, int n);
+
+// Times every kernel against a per-pixel loop and logs Mpixel/s (PIXEL_BENCH_ROWS)
+void pxBenchmark();
+
+#endif // PIXEL_KERNELS_H
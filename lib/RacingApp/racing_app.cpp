@@ -1,5 +1,7 @@
 #include "racing_app.h"
 #include "display.h"
+#include "glyph_text.h"
+#include "pixel_kernels.h"
 #include <Arduino.h>
 
 RacingApp racingApp;
@@ -40,11 +42,9 @@ void RacingApp::resetGame()
 void RacingApp::drawScene(GFXcanvas16 *canvas)
 {
     // ── Sky gradient ──────────────────────────────────────
-    for (int y = 0; y < HORIZON_Y; y++)
-    {
-        uint16_t c = (y < HORIZON_Y / 2) ? 0x0318 : 0x54FB;
-        canvas->drawFastHLine(0, y, 128, c);
-    }
+    uint16_t *buf = canvas->getBuffer();
+    pxFill(buf, canvasColor(0x0318), 128 * (HORIZON_Y / 2));
+    pxFill(buf + 128 * (HORIZON_Y / 2), canvasColor(0x54FB), 128 * (HORIZON_Y - HORIZON_Y / 2));
 
     // ── Road (perspective scan-lines) ─────────────────────
     // For each screen row y from horizon to bottom:
@@ -70,30 +70,31 @@ void RacingApp::drawScene(GFXcanvas16 *canvas)
         bool bright = (((int)((_distance + Z) / STRIP_LEN)) % 2 == 0);
 
         // Grass
-        uint16_t gCol = bright ? 0x07E0 : 0x03E0;
-        if (left > 0)   canvas->drawFastHLine(0,     y, left,       gCol);
-        if (right < 128) canvas->drawFastHLine(right, y, 128 - right, gCol);
-
-        // Road surface
-        uint16_t rCol = bright ? 0x6B4D : 0x4A49;
+        uint16_t gCol = bright ? canvasColor(0x07E0) : canvasColor(0x03E0);
+        uint16_t *row = buf + y * 128;
         int rL = max(0, left);
         int rR = min(128, right);
-        if (rR > rL) canvas->drawFastHLine(rL, y, rR - rL, rCol);
+        if (rL > 0)   pxFill(row,      gCol, min(rL, 128));
+        if (rR < 128) pxFill(row + max(rR, 0), gCol, 128 - max(rR, 0));
+
+        // Road surface
+        uint16_t rCol = bright ? canvasColor(0x6B4D) : canvasColor(0x4A49);
+        if (rR > rL) pxFill(row + rL, rCol, rR - rL);
 
         // White edge lines
         for (int e = 0; e <= 1; e++)
         {
             int lx = left  + e;
             int rx = right - e;
-            if (lx >= 0 && lx < 128) canvas->drawPixel(lx, y, 0xFFFF);
-            if (rx >= 0 && rx < 128) canvas->drawPixel(rx, y, 0xFFFF);
+            if (lx >= 0 && lx < 128) canvas->drawPixel(lx, y, canvasColor(0xFFFF));
+            if (rx >= 0 && rx < 128) canvas->drawPixel(rx, y, canvasColor(0xFFFF));
         }
 
         // Yellow dashed centre line
         if (((int)((_distance + Z) / (STRIP_LEN * 0.6f))) % 2 == 0)
         {
             int cx = (int)centerX;
-            if (cx >= 0 && cx < 128) canvas->drawPixel(cx, y, 0xFFE0);
+            if (cx >= 0 && cx < 128) canvas->drawPixel(cx, y, canvasColor(0xFFE0));
         }
     }
 }
@@ -103,38 +104,31 @@ void RacingApp::drawCar(GFXcanvas16 *canvas)
     int x = (int)_carX;
     int y = 128 - CAR_H - 2;
 
-    canvas->fillRect(x - CAR_W / 2,     y,            CAR_W, CAR_H, 0x001F); // body
-    canvas->fillRect(x - 3,             y + 2,         6,     4,     0x07FF); // windshield
-    canvas->fillRect(x - CAR_W / 2,     y,             2,     4,     0x0000); // wheel FL
-    canvas->fillRect(x + CAR_W / 2 - 2, y,             2,     4,     0x0000); // wheel FR
-    canvas->fillRect(x - CAR_W / 2,     y + CAR_H - 4, 2,     4,     0x0000); // wheel RL
-    canvas->fillRect(x + CAR_W / 2 - 2, y + CAR_H - 4, 2,     4,     0x0000); // wheel RR
+    canvas->fillRect(x - CAR_W / 2,     y,            CAR_W, CAR_H, canvasColor(0x001F)); // body
+    canvas->fillRect(x - 3,             y + 2,         6,     4,     canvasColor(0x07FF)); // windshield
+    canvas->fillRect(x - CAR_W / 2,     y,             2,     4,     0x0000);              // wheel FL
+    canvas->fillRect(x + CAR_W / 2 - 2, y,             2,     4,     0x0000);              // wheel FR
+    canvas->fillRect(x - CAR_W / 2,     y + CAR_H - 4, 2,     4,     0x0000);              // wheel RL
+    canvas->fillRect(x + CAR_W / 2 - 2, y + CAR_H - 4, 2,     4,     0x0000);              // wheel RR
 }
 
 void RacingApp::drawHUD(GFXcanvas16 *canvas)
 {
-    canvas->setTextColor(0xFFFF);
-    canvas->setTextSize(1);
-    canvas->setCursor(2, 2);
-    canvas->print(_score);
+    char score[12];
+    snprintf(score, sizeof(score), "%d", _score);
+    glyphText.draw(canvas, 2, 2, score, canvasColor(0xFFFF));
 }
 
 void RacingApp::drawGameOver(GFXcanvas16 *canvas)
 {
     canvas->fillScreen(0x0000);
-    canvas->setTextColor(0xF800);
-    canvas->setTextSize(2);
-    canvas->setCursor(10, 28);
-    canvas->print("GAME");
-    canvas->setCursor(10, 48);
-    canvas->print("OVER");
-    canvas->setTextColor(0xFFFF);
-    canvas->setTextSize(1);
-    canvas->setCursor(10, 78);
-    canvas->print("Score: ");
-    canvas->print(_score);
-    canvas->setCursor(5, 98);
-    canvas->print("Shake to retry");
+    glyphText.draw(canvas, 10, 28, "GAME", canvasColor(0xF800), 2);
+    glyphText.draw(canvas, 10, 48, "OVER", canvasColor(0xF800), 2);
+
+    char score[20];
+    snprintf(score, sizeof(score), "Score: %d", _score);
+    glyphText.draw(canvas, 10, 78, score, canvasColor(0xFFFF));
+    glyphText.draw(canvas, 5, 98, "Shake to retry", canvasColor(0xFFFF));
 }
 
 void RacingApp::loop()
@@ -195,9 +189,5 @@ void RacingApp::loop()
         drawHUD(canvas);
     }
 
-    updateOverlay();
-    if (isOverlayVisible())
-        display.drawOverlay(false, display.getTimeString(), name(), 0, 0);
-
     display.swapAndRender();
 }
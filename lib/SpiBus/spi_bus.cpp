@@ -0,0 +1,75 @@
+#include "spi_bus.h"
+
+SpiBus spiBus;
+
+static const char *const CLIENT_NAMES[SPI_CLIENT_COUNT] = {"panel", "loader", "upload", "web"};
+
+void SpiBus::begin()
+{
+    if (_mutex == NULL)
+        _mutex = xSemaphoreCreateRecursiveMutex();
+}
+
+void SpiBus::acquire(SpiClient client)
+{
+    if (_mutex == NULL)
+        return;
+
+    uint32_t startUs = micros();
+    xSemaphoreTakeRecursive(_mutex, portMAX_DELAY);
+    if (_depth++ > 0)
+        return;
+
+    uint32_t now = micros();
+    uint32_t waitUs = now - startUs;
+    SpiBusStats &s = _stats[client];
+    s.acquisitions++;
+    s.waitUs += waitUs;
+    if (waitUs > s.maxWaitUs)
+        s.maxWaitUs = waitUs;
+    _heldSince = now;
+}
+
+void SpiBus::release(SpiClient client)
+{
+    if (_mutex == NULL)
+        return;
+
+    // Snapshot while still owning the bus; print after handing it back
+    SpiBusStats snapshot[SPI_CLIENT_COUNT];
+    bool report = false;
+    if (--_depth == 0)
+    {
+        _stats[client].holdUs += micros() - _heldSince;
+        if (SPI_BUS_STATS_MS > 0 && millis() - _lastLogMs >= SPI_BUS_STATS_MS)
+        {
+            _lastLogMs = millis();
+            memcpy(snapshot, _stats, sizeof(snapshot));
+            resetStats();
+            report = true;
+        }
+    }
+    xSemaphoreGiveRecursive(_mutex);
+
+    if (report)
+        logStats(snapshot);
+}
+
+void SpiBus::resetStats()
+{
+    memset(_stats, 0, sizeof(_stats));
+}
+
+void SpiBus::logStats(const SpiBusStats *stats)
+{
+    for (int i = 0; i < SPI_CLIENT_COUNT; i++)
+    {
+        const SpiBusStats &s = stats[i];
+        if (s.acquisitions == 0)
+            continue;
+        Serial.printf("[SpiBus] %s: %u bursts, wait avg %u us / max %u us, held %u ms\n",
+                      CLIENT_NAMES[i], (unsigned)s.acquisitions,
+                      (unsigned)(s.waitUs / s.acquisitions), (unsigned)s.maxWaitUs,
+                      (unsigned)(s.holdUs / 1000));
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef SPI_BUS_H
+#define SPI_BUS_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// The SD card and the TFT share SCK/MOSI. Each client takes the bus for a
+// whole burst (one panel push, one decoded frame, one upload chunk) instead
+// of interleaving at SPI transaction granularity.
+enum SpiClient : uint8_t
+{
+    SPI_CLIENT_PANEL,  // Display pushes and direct panel drawing
+    SPI_CLIENT_LOADER, // frame decoding SD reads (FrameLoader, NowPlaying scene)
+    SPI_CLIENT_UPLOAD, // web upload SD writes
+    SPI_CLIENT_WEB,    // web frame preview SD reads
+    SPI_CLIENT_COUNT
+};
+
+struct SpiBusStats
+{
+    uint32_t acquisitions;
+    uint32_t waitUs;    // total time spent waiting for the bus
+    uint32_t maxWaitUs; // longest single wait
+    uint32_t holdUs;    // total time holding it
+};
+
+class SpiBus
+{
+public:
+    void begin();
+
+    // Recursive for the same task; blocks until the bus is free
+    void acquire(SpiClient client);
+    void release(SpiClient client);
+
+    // Totals since the last periodic log (SPI_BUS_STATS_MS)
+    const SpiBusStats &stats(SpiClient client) const { return _stats[client]; }
+    void resetStats();
+
+private:
+    SemaphoreHandle_t _mutex = NULL;
+    SpiBusStats _stats[SPI_CLIENT_COUNT] = {};
+    int _depth = 0; // nesting of the current owner
+    uint32_t _heldSince = 0;
+    unsigned long _lastLogMs = 0;
+
+    static void logStats(const SpiBusStats *stats);
+};
+
+extern SpiBus spiBus;
+
+// Holds the bus for the lifetime of the scope
+class SpiBusScope
+{
+public:
+    explicit SpiBusScope(SpiClient client) : _client(client) { spiBus.acquire(client); }
+    ~SpiBusScope() { spiBus.release(_client); }
+
+private:
+    SpiClient _client;
+};
+
+#endif // SPI_BUS_H
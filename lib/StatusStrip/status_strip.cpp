@@ -0,0 +1,146 @@
+#include "status_strip.h"
+#include "glyph_text.h"
+#include "perf_stats.h"
+#include <WiFi.h>
+
+StatusStrip statusStrip;
+
+static const int TEXT_Y = (STATUS_HEIGHT - GlyphText::GLYPH_H) / 2;
+static const int MARGIN = 2;
+
+StatusStrip::StatusStrip()
+    : _bands(nullptr), _pushedClears(0), _lastPoll(0)
+{
+    memset(_fields, 0, sizeof(_fields));
+    _title[0] = '\0';
+    memset(_dirty, 0, sizeof(_dirty));
+}
+
+void StatusStrip::begin()
+{
+    _bands = new GFXcanvas16(TFT_WIDTH, STATUS_HEIGHT * 2);
+    if (_bands && !_bands->getBuffer())
+    {
+        delete _bands;
+        _bands = nullptr;
+    }
+    if (!_bands)
+    {
+        Serial.println("[StatusStrip] Band allocation failed");
+        return;
+    }
+    _bands->fillScreen(0);
+    _pushedClears = display.clearCount() - 1; // first push repaints both bands
+    _lastPoll = millis() - STATUS_POLL_MS;
+}
+
+void StatusStrip::setTitle(const char *title)
+{
+    strlcpy(_title, title, sizeof(_title));
+    layoutTitle(_fields[STATUS_POSITION].w);
+}
+
+void StatusStrip::setPosition(int current, int total)
+{
+    char pos[12] = "";
+    if (total > 0)
+        snprintf(pos, sizeof(pos), "%d/%d", current, total);
+
+    // Shorten the title before a wider position is drawn over it; lengthen it
+    // only once a narrower one has cleared its old pixels
+    int w = GlyphText::width(pos);
+    bool wider = w > _fields[STATUS_POSITION].w;
+    if (wider)
+        layoutTitle(w);
+    setField(STATUS_POSITION, pos, canvasColor(ST77XX_YELLOW));
+    if (!wider)
+        layoutTitle(w);
+}
+
+// Cuts the title to whatever the right-aligned position leaves, ending in ".."
+void StatusStrip::layoutTitle(int positionWidth)
+{
+    int room = TFT_WIDTH - 2 * MARGIN - (positionWidth > 0 ? positionWidth + GlyphText::GLYPH_W : 0);
+    size_t maxLen = min((size_t)max(room / GlyphText::GLYPH_W, 2), sizeof(Field::text) - 1);
+
+    char shown[sizeof(Field::text)];
+    size_t len = strlen(_title);
+    if (len > maxLen)
+    {
+        memcpy(shown, _title, maxLen - 2);
+        shown[maxLen - 2] = '.';
+        shown[maxLen - 1] = '.';
+        shown[maxLen] = '\0';
+    }
+    else
+    {
+        memcpy(shown, _title, len + 1);
+    }
+    setField(STATUS_TITLE, shown, canvasColor(ST77XX_CYAN));
+}
+
+void StatusStrip::setField(StatusField field, const char *text, uint16_t color)
+{
+    Field &f = _fields[field];
+    if (!_bands || (f.color == color && strncmp(f.text, text, sizeof(f.text)) == 0))
+        return;
+
+    int band = field / 2;
+    int y = band * STATUS_HEIGHT + TEXT_Y;
+    DirtyRect dirty = {f.x, (int16_t)(band * STATUS_HEIGHT + TEXT_Y), f.w, GlyphText::GLYPH_H};
+    if (f.w > 0)
+        _bands->fillRect(f.x, y, f.w, GlyphText::GLYPH_H, 0);
+
+    strlcpy(f.text, text, sizeof(f.text));
+    f.color = color;
+    f.w = GlyphText::width(f.text);
+    f.x = (field & 1) ? TFT_WIDTH - f.w - MARGIN : MARGIN;
+    glyphText.draw(_bands, f.x, y, f.text, color);
+
+    mergeDirty(dirty, {f.x, dirty.y, f.w, GlyphText::GLYPH_H});
+    dirty.y -= band * STATUS_HEIGHT;
+    mergeDirty(_dirty[band], dirty);
+}
+
+void StatusStrip::loop()
+{
+    if (!_bands)
+        return;
+
+    if (millis() - _lastPoll >= STATUS_POLL_MS)
+    {
+        _lastPoll = millis();
+        if (WiFi.status() == WL_CONNECTED)
+            setField(STATUS_WIFI, "WiFi", canvasColor(ST77XX_GREEN));
+        else if (WiFi.getMode() & WIFI_AP)
+            setField(STATUS_WIFI, "AP", canvasColor(ST77XX_YELLOW));
+        else
+            setField(STATUS_WIFI, "----", canvasColor(ST77XX_RED));
+        setField(STATUS_TIME, display.getTimeString(), canvasColor(ST77XX_WHITE));
+    }
+    push();
+}
+
+void StatusStrip::push()
+{
+    // Something painted over the whole panel; both bands need to go out again
+    if (display.clearCount() != _pushedClears)
+    {
+        _pushedClears = display.clearCount();
+        _dirty[0] = _dirty[1] = {0, 0, TFT_WIDTH, STATUS_HEIGHT};
+    }
+    if (_dirty[0].w <= 0 && _dirty[1].w <= 0)
+        return;
+
+    PerfScope probe(PERF_STATUS);
+    static const int BAND_Y[2] = {0, STATUS_BOTTOM_Y};
+    for (int band = 0; band < 2; band++)
+    {
+        DirtyRect &d = _dirty[band];
+        if (d.w <= 0 || d.h <= 0)
+            continue;
+        const uint16_t *src = _bands->getBuffer() + (band * STATUS_HEIGHT + d.y) * TFT_WIDTH + d.x;
+        display.pushRect(d.x, BAND_Y[band] + d.y, d.w, d.h, src, TFT_WIDTH);
+        d = {0, 0, 0, 0};
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef STATUS_STRIP_H
+#define STATUS_STRIP_H
+
+#include <Arduino.h>
+#include <Adafruit_GFX.h>
+#include "config.h"
+#include "display.h"
+
+// Fields of the two bands; even ones sit on the left, odd ones right-aligned
+enum StatusField : uint8_t
+{
+    STATUS_WIFI,     // top left
+    STATUS_TIME,     // top right
+    STATUS_TITLE,    // bottom left: app or GIF name
+    STATUS_POSITION, // bottom right: "3/12"
+    STATUS_FIELD_COUNT
+};
+
+// Owns the panel rows above and below the canvas, which frames never touch.
+// Each field is redrawn in a small band buffer only when its text changes,
+// and just the pixels that changed are written to the panel.
+class StatusStrip
+{
+public:
+    StatusStrip();
+
+    void begin();
+
+    void setTitle(const char *title);
+    // total <= 0 hides the position
+    void setPosition(int current, int total);
+
+    // Polls wifi and the clock every STATUS_POLL_MS and pushes whatever changed
+    // since the last call. Main loop (core 1) only.
+    void loop();
+
+private:
+    struct Field
+    {
+        char text[16];
+        uint16_t color;
+        int16_t x;
+        int16_t w;
+    };
+
+    GFXcanvas16 *_bands; // top band in rows [0, STATUS_HEIGHT), bottom band below it
+    Field _fields[STATUS_FIELD_COUNT];
+    char _title[MAX_GIF_NAME_LEN + 1]; // untruncated; shown as far as the position allows
+    DirtyRect _dirty[2]; // per band, in band coordinates
+    uint32_t _pushedClears; // display.clearCount() at the last full push
+    unsigned long _lastPoll;
+
+    void setField(StatusField field, const char *text, uint16_t color);
+    void layoutTitle(int positionWidth);
+    void push();
+};
+
+extern StatusStrip statusStrip;
+
+#endif // STATUS_STRIP_H
@@ -1,13 +1,20 @@
 #include "gif_routes.h"
 #include "upload_manager.h"
 #include "gif_manager.h"
+#include "frame_loader.h"
+#include "frame_pack.h"
+#include "display.h"
+#include "spi_bus.h"
+#include "pixel_kernels.h"
 #include "config.h"
 #include <SD.h>
 #include <ArduinoJson.h>
 #include <AsyncJson.h>
 #include <vector>
+#include <memory>
 
 static void (*_onGifChange)() = nullptr;
+static uint16_t _createDelays[MAX_GIF_FRAMES];
 
 void GifRoutes::setOnGifChange(void (*callback)())
 {
@@ -26,6 +33,15 @@ static void uploadResponseHandler(AsyncWebServerRequest *request)
     }
 }
 
+// The library is being rebuilt in the background and cannot change yet
+static bool rejectWhileScanning(AsyncWebServerRequest *request)
+{
+    if (!gifManager.isScanning())
+        return false;
+    request->send(503, "application/json", "{\"error\":\"Library scan in progress\"}");
+    return true;
+}
+
 static void handleGetGifs(AsyncWebServerRequest *request)
 {
     JsonDocument doc;
@@ -44,6 +60,7 @@ static void handleGetGifs(AsyncWebServerRequest *request)
             obj["width"] = info.width;
             obj["height"] = info.height;
             obj["defaultDelay"] = info.defaultDelay;
+            obj["original"] = info.original;
         }
     }
 
@@ -69,6 +86,7 @@ static void handleGetGifInfo(AsyncWebServerRequest *request)
     doc["width"] = info.width;
     doc["height"] = info.height;
     doc["defaultDelay"] = info.defaultDelay;
+    doc["original"] = info.original;
 
     String response;
     serializeJson(doc, response);
@@ -78,17 +96,26 @@ static void handleGetGifInfo(AsyncWebServerRequest *request)
 static void handleDeleteGif(AsyncWebServerRequest *request)
 {
     const String &name = request->pathArg(0);
+    if (rejectWhileScanning(request))
+        return;
 
-    if (gifManager.deleteGif(name.c_str()))
+    // Detach the loader from this GIF so it can't reopen a file mid-delete
+    char dir[64];
+    snprintf(dir, sizeof(dir), "%s/%s", GIFS_ROOT, name.c_str());
+    if (!frameLoader.releasePack(dir))
     {
-        if (_onGifChange)
-            _onGifChange();
-        request->send(200, "application/json", "{\"success\":true}");
+        request->send(503, "application/json", "{\"error\":\"Player busy, try again\"}");
+        return;
     }
+
+    // GifApp picks a new GIF either way; a detached job shows nothing
+    bool deleted = gifManager.deleteGif(name.c_str());
+    if (_onGifChange)
+        _onGifChange();
+    if (deleted)
+        request->send(200, "application/json", "{\"success\":true}");
     else
-    {
         request->send(500, "application/json", "{\"error\":\"Failed to delete\"}");
-    }
 }
 
 static void handleCreateGif(AsyncWebServerRequest *request, JsonVariant &json)
@@ -100,14 +127,35 @@ static void handleCreateGif(AsyncWebServerRequest *request, JsonVariant &json)
     int width = obj["width"] | CANVAS_WIDTH;
     int height = obj["height"] | CANVAS_HEIGHT;
     uint16_t defaultDelay = obj["defaultDelay"] | 100;
+    bool original = obj["original"] | false;
 
-    if (strlen(name) == 0 || strlen(name) > MAX_GIF_NAME_LEN || frameCount == 0)
+    if (strlen(name) == 0 || strlen(name) > MAX_GIF_NAME_LEN || frameCount == 0 ||
+        width <= 0 || width > MAX_IMAGE_SIZE || height <= 0 || height > MAX_IMAGE_SIZE)
     {
         request->send(400, "application/json", "{\"error\":\"Invalid parameters\"}");
         return;
     }
+    if (rejectWhileScanning(request))
+        return;
+
+    // Optional per-frame delays; frames past MAX_GIF_FRAMES fall back to defaultDelay
+    JsonArray delays = obj["delays"].as<JsonArray>();
+    const uint16_t *delayTable = nullptr;
+    if (!delays.isNull())
+    {
+        int n = 0;
+        for (JsonVariant v : delays)
+        {
+            if (n >= MAX_GIF_FRAMES)
+                break;
+            _createDelays[n++] = v | defaultDelay;
+        }
+        for (; n < MAX_GIF_FRAMES; n++)
+            _createDelays[n] = defaultDelay;
+        delayTable = _createDelays;
+    }
 
-    if (gifManager.createGif(name, frameCount, width, height, defaultDelay))
+    if (gifManager.createGif(name, frameCount, width, height, defaultDelay, delayTable, original))
     {
         if (_onGifChange)
             _onGifChange();
@@ -129,12 +177,31 @@ static void handleUploadFrame(AsyncWebServerRequest *request, const String &file
         uploadManager.setError(false);
         uploadManager.touchTimestamp();
 
+        // The loader keeps its own handle and header for the pack being extended;
+        // it stays paused while uploading and reopens a fresh one afterwards
+        if (!frameLoader.releasePack())
+        {
+            uploadManager.setError(true);
+            return;
+        }
+
         char path[64];
-        snprintf(path, sizeof(path), "%s/%s/%s.bmp",
-                 GIFS_ROOT, request->pathArg(0).c_str(), request->pathArg(1).c_str());
+        snprintf(path, sizeof(path), "%s/%s/%s",
+                 GIFS_ROOT, request->pathArg(0).c_str(), GIF_PACK_FILE);
 
-        if (!uploadManager.openFile(path))
-            return;
+        if (SD.exists(path))
+        {
+            if (!uploadManager.openPackFrame(path, request->pathArg(1).toInt()))
+                return;
+        }
+        else
+        {
+            snprintf(path, sizeof(path), "%s/%s/%s.bmp",
+                     GIFS_ROOT, request->pathArg(0).c_str(), request->pathArg(1).c_str());
+
+            if (!uploadManager.openFile(path))
+                return;
+        }
     }
 
     uploadManager.writeChunk(data, len);
@@ -145,9 +212,122 @@ static void handleUploadFrame(AsyncWebServerRequest *request, const String &file
     }
 }
 
+// Serves one pack frame as a top-down 16-bit BI_BITFIELDS BMP for the web preview.
+// Raw frames stream from the file; other codecs are expanded into a heap frame first.
+static bool sendPackedFrame(AsyncWebServerRequest *request, const char *packPath, int index)
+{
+    File f;
+    {
+        SpiBusScope bus(SPI_CLIENT_WEB);
+        f = SD.open(packPath, FILE_READ);
+    }
+    PackHeader hdr;
+    PackFrameEntry entry;
+    if (!f || !FramePack::readHeader(f, hdr, SPI_CLIENT_WEB) ||
+        !FramePack::readEntry(f, hdr, index, entry, SPI_CLIENT_WEB) ||
+        entry.offset == 0)
+        return false;
+
+    std::shared_ptr<uint16_t> pixels;
+    if (entry.codec != PACK_CODEC_RAW565)
+    {
+        pixels.reset((uint16_t *)malloc(FrameLoader::FRAME_BYTES), free);
+        bool ok = pixels && display.decodePackFrame(f, hdr, index, pixels.get(), SPI_CLIENT_WEB);
+        f.close();
+        if (!ok)
+            return false;
+
+        // Crop the centred frame to raw pack layout: packed rows, little-endian
+        uint16_t *fb = pixels.get();
+        const uint16_t *src = fb + ((CANVAS_HEIGHT - hdr.height) >> 1) * CANVAS_WIDTH +
+                              ((CANVAS_WIDTH - hdr.width) >> 1);
+        for (int y = 0; y < hdr.height; y++)
+            memmove(fb + y * hdr.width, src + y * CANVAS_WIDTH, hdr.width * 2);
+        if (CANVAS_BIG_ENDIAN)
+            pxByteSwap(fb, fb, hdr.width * hdr.height);
+    }
+
+    const uint32_t headerSize = 66;
+    const uint32_t lineBytes = hdr.width * 2;
+    const uint32_t rowSize = (lineBytes + 3) & ~3;
+    const uint32_t pixelBytes = rowSize * hdr.height;
+    const size_t total = headerSize + pixelBytes;
+    const uint32_t offset = entry.offset;
+
+    uint8_t header[headerSize] = {};
+    auto put32 = [&header](int pos, uint32_t v)
+    {
+        header[pos] = v;
+        header[pos + 1] = v >> 8;
+        header[pos + 2] = v >> 16;
+        header[pos + 3] = v >> 24;
+    };
+    header[0] = 'B';
+    header[1] = 'M';
+    put32(2, total);
+    put32(10, headerSize);
+    put32(14, 40);
+    put32(18, hdr.width);
+    put32(22, (uint32_t)(-(int32_t)hdr.height));
+    header[26] = 1;
+    header[28] = 16;
+    put32(30, 3);
+    put32(34, pixelBytes);
+    put32(54, 0xF800);
+    put32(58, 0x07E0);
+    put32(62, 0x001F);
+
+    auto *response = request->beginResponse("image/bmp", total,
+        [f, pixels, header, offset, lineBytes, rowSize, total](uint8_t *buffer, size_t maxLen, size_t index) mutable -> size_t
+        {
+            size_t written = 0;
+            while (written < maxLen && index < total)
+            {
+                size_t n;
+                if (index < headerSize)
+                {
+                    n = min((size_t)(headerSize - index), maxLen - written);
+                    memcpy(buffer + written, header + index, n);
+                }
+                else
+                {
+                    uint32_t pos = index - headerSize;
+                    uint32_t row = pos / rowSize;
+                    uint32_t col = pos % rowSize;
+                    n = min((size_t)(rowSize - col), maxLen - written);
+                    size_t pix = (col < lineBytes) ? min(n, (size_t)(lineBytes - col)) : 0;
+                    if (pix > 0 && pixels)
+                        memcpy(buffer + written, (const uint8_t *)pixels.get() + row * lineBytes + col, pix);
+                    else if (pix > 0)
+                    {
+                        SpiBusScope bus(SPI_CLIENT_WEB);
+                        if (!f.seek(offset + row * lineBytes + col) || f.read(buffer + written, pix) != pix)
+                            return written;
+                    }
+                    memset(buffer + written + pix, 0, n - pix);
+                }
+                written += n;
+                index += n;
+            }
+            return written;
+        });
+    request->send(response);
+    return true;
+}
+
 static void handleGetFrame(AsyncWebServerRequest *request)
 {
     char path[64];
+    snprintf(path, sizeof(path), "%s/%s/%s",
+             GIFS_ROOT, request->pathArg(0).c_str(), GIF_PACK_FILE);
+
+    if (SD.exists(path))
+    {
+        if (!sendPackedFrame(request, path, request->pathArg(1).toInt()))
+            request->send(404, "text/plain", "Frame not found");
+        return;
+    }
+
     snprintf(path, sizeof(path), "%s/%s/%s.bmp",
              GIFS_ROOT, request->pathArg(0).c_str(), request->pathArg(1).c_str());
 
@@ -168,9 +348,17 @@ static void handleUploadOriginal(AsyncWebServerRequest *request, const String &f
         uploadManager.setError(false);
         uploadManager.touchTimestamp();
 
+        // The loader may be streaming this very file
+        uploadManager.setUploading(true);
+        if (!frameLoader.releasePack())
+        {
+            uploadManager.setError(true);
+            return;
+        }
+
         char path[64];
-        snprintf(path, sizeof(path), "%s/%s/original.gif",
-                 GIFS_ROOT, request->pathArg(0).c_str());
+        snprintf(path, sizeof(path), "%s/%s/%s",
+                 GIFS_ROOT, request->pathArg(0).c_str(), GIF_ORIGINAL_FILE);
 
         if (!uploadManager.openOriginal(path))
             return;
@@ -193,8 +381,8 @@ static void handleUploadOriginal(AsyncWebServerRequest *request, const String &f
 static void handleGetOriginal(AsyncWebServerRequest *request)
 {
     char path[64];
-    snprintf(path, sizeof(path), "%s/%s/original.gif",
-             GIFS_ROOT, request->pathArg(0).c_str());
+    snprintf(path, sizeof(path), "%s/%s/%s",
+             GIFS_ROOT, request->pathArg(0).c_str(), GIF_ORIGINAL_FILE);
 
     if (!SD.exists(path))
     {
@@ -217,12 +405,17 @@ static void handleReorder(AsyncWebServerRequest *request, JsonVariant &json)
         request->send(400, "application/json", "{\"error\":\"Invalid order\"}");
         return;
     }
+    if (rejectWhileScanning(request))
+        return;
 
-    std::vector<String> names;
+    // Views into the request's JSON document, which outlives the call
+    std::vector<const char *> names;
     names.reserve(order.size());
     for (JsonVariant v : order)
     {
-        names.push_back(v.as<String>());
+        const char *name = v.as<const char *>();
+        if (name)
+            names.push_back(name);
     }
 
     if (gifManager.reorderGifs(names))
@@ -237,6 +430,41 @@ static void handleReorder(AsyncWebServerRequest *request, JsonVariant &json)
     }
 }
 
+static void handleGetPlayback(AsyncWebServerRequest *request)
+{
+    JsonDocument doc;
+    doc["residentBudget"] = frameLoader.residentBudget();
+    doc["residentFrames"] = frameLoader.residentFrames();
+    doc["maxResidentFrames"] = MAX_RESIDENT_FRAMES;
+    doc["frameBytes"] = FrameLoader::FRAME_BYTES;
+    doc["queueDepth"] = frameLoader.depth();
+    doc["freeHeap"] = ESP.getFreeHeap();
+
+    String response;
+    serializeJson(doc, response);
+    request->send(200, "application/json", response);
+}
+
+static void handleSetPlayback(AsyncWebServerRequest *request, JsonVariant &json)
+{
+    JsonObject obj = json.as<JsonObject>();
+    long budget = obj["residentBudget"] | -1L;
+
+    if (budget < 0)
+    {
+        request->send(400, "application/json", "{\"error\":\"Invalid residentBudget\"}");
+        return;
+    }
+
+    frameLoader.setResidentBudget(budget);
+
+    // Reload so the current GIF is re-evaluated against the new budget
+    if (_onGifChange)
+        _onGifChange();
+
+    request->send(200, "application/json", "{\"success\":true}");
+}
+
 void GifRoutes::registerRoutes(AsyncWebServer &server)
 {
     server.on("/api/gifs", HTTP_GET, handleGetGifs);
@@ -266,4 +494,9 @@ void GifRoutes::registerRoutes(AsyncWebServer &server)
 
     auto *reorderHandler = new AsyncCallbackJsonWebHandler("/api/reorder", handleReorder);
     server.addHandler(reorderHandler);
+
+    server.on("/api/playback", HTTP_GET, handleGetPlayback);
+
+    auto *playbackHandler = new AsyncCallbackJsonWebHandler("/api/playback", handleSetPlayback);
+    server.addHandler(playbackHandler);
 }
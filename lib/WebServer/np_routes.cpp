@@ -11,18 +11,16 @@ static void handleNowPlaying(AsyncWebServerRequest *request, JsonVariant &json)
     JsonObject obj = json.as<JsonObject>();
     const char *title = obj["title"] | "";
     const char *artist = obj["artist"] | "";
-    int frameCount = obj["frameCount"] | 0;
 
-    if (strlen(title) == 0 || frameCount <= 0)
+    if (strlen(title) == 0)
     {
-        request->send(400, "application/json", "{\"error\":\"title and frameCount required\"}");
+        request->send(400, "application/json", "{\"error\":\"title required\"}");
         return;
     }
 
-    nowPlayingApp.updateTrack(title, artist, frameCount);
+    nowPlayingApp.updateTrack(title, artist);
 
-    Serial.printf("[NpRoutes] Track: \"%s\" (%d frames). Free heap: %u\n",
-                  title, frameCount, ESP.getFreeHeap());
+    Serial.printf("[NpRoutes] Track: \"%s\". Free heap: %u\n", title, ESP.getFreeHeap());
     request->send(200, "application/json", "{\"success\":true}");
 }
 
@@ -33,7 +31,6 @@ static void handleGetNowPlaying(AsyncWebServerRequest *request)
     JsonDocument doc;
     doc["title"] = info.title;
     doc["artist"] = info.artist;
-    doc["frameCount"] = info.frameCount;
     doc["framesReady"] = info.framesReady;
     doc["active"] = (info.lastUpdate > 0);
 
@@ -97,6 +94,34 @@ static void handleUploadNpFrame(AsyncWebServerRequest *request, const String &fi
     }
 }
 
+// Title / artist marquee strip, see NpStripHeader
+static void handleUploadNpStrip(AsyncWebServerRequest *request, const String &filename,
+                                size_t index, uint8_t *data, size_t len, bool final)
+{
+    if (index == 0)
+    {
+        if (uploadManager.isFileOpen())
+            uploadManager.closeFile();
+
+        uploadManager.setError(false);
+        uploadManager.touchTimestamp();
+
+        char path[64];
+        snprintf(path, sizeof(path), "%s/%s.bin",
+                 NP_DIR, request->pathArg(0).c_str());
+
+        if (!uploadManager.openFile(path))
+            return;
+    }
+
+    uploadManager.writeChunk(data, len);
+
+    if (final)
+    {
+        uploadManager.closeFile();
+    }
+}
+
 static void handleNpReady(AsyncWebServerRequest *request)
 {
     uploadManager.setUploading(false);
@@ -112,21 +137,20 @@ void NpRoutes::registerRoutes(AsyncWebServer &server)
     auto *npHandler = new AsyncCallbackJsonWebHandler("/api/now-playing", handleNowPlaying);
     server.addHandler(npHandler);
 
-    server.on(
-        "^\\/api\\/np\\/frame\\/([0-9]+)$",
-        HTTP_POST,
-        [](AsyncWebServerRequest *request)
+    auto uploadResponse = [](AsyncWebServerRequest *request)
+    {
+        if (uploadManager.consumeError())
         {
-            if (uploadManager.consumeError())
-            {
-                request->send(500, "application/json", "{\"error\":\"SD write failed\"}");
-            }
-            else
-            {
-                request->send(200, "application/json", "{\"success\":true}");
-            }
-        },
-        handleUploadNpFrame);
+            request->send(500, "application/json", "{\"error\":\"SD write failed\"}");
+        }
+        else
+        {
+            request->send(200, "application/json", "{\"success\":true}");
+        }
+    };
+
+    server.on("^\\/api\\/np\\/frame\\/([0-9]+)$", HTTP_POST, uploadResponse, handleUploadNpFrame);
+    server.on("^\\/api\\/np\\/strip\\/(title|artist)$", HTTP_POST, uploadResponse, handleUploadNpStrip);
 
     server.on("/api/np/ready", HTTP_POST, handleNpReady);
 }
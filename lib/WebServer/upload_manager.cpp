@@ -1,4 +1,5 @@
 #include "upload_manager.h"
+#include "spi_bus.h"
 
 UploadManager uploadManager;
 
@@ -16,7 +17,9 @@ bool UploadManager::consumeError()
 
 bool UploadManager::openFile(const char *path)
 {
+    spiBus.acquire(SPI_CLIENT_UPLOAD);
     _file = SD.open(path, FILE_WRITE);
+    spiBus.release(SPI_CLIENT_UPLOAD);
     if (!_file)
     {
         Serial.printf("[Upload] Cannot create: %s\n", path);
@@ -29,12 +32,45 @@ bool UploadManager::openFile(const char *path)
     return true;
 }
 
+bool UploadManager::openPackFrame(const char *packPath, int index)
+{
+    spiBus.acquire(SPI_CLIENT_UPLOAD);
+    bool ok = _packWriter.begin(packPath, index);
+    spiBus.release(SPI_CLIENT_UPLOAD);
+    if (!ok)
+    {
+        _uploadError = true;
+        return false;
+    }
+    strncpy(_path, packPath, sizeof(_path) - 1);
+    _path[sizeof(_path) - 1] = '\0';
+    _packOpen = true;
+    return true;
+}
+
 bool UploadManager::writeChunk(const uint8_t *data, size_t len)
 {
+    if (_packOpen && !_uploadError)
+    {
+        _lastUploadMs = millis();
+        spiBus.acquire(SPI_CLIENT_UPLOAD);
+        bool ok = _packWriter.write(data, len);
+        spiBus.release(SPI_CLIENT_UPLOAD);
+        if (!ok)
+        {
+            Serial.printf("[Upload] Pack write error: %s\n", _path);
+            _uploadError = true;
+            return false;
+        }
+        return true;
+    }
+
     if (!_fileOpen || _uploadError)
         return false;
     _lastUploadMs = millis();
+    spiBus.acquire(SPI_CLIENT_UPLOAD);
     size_t written = _file.write(data, len);
+    spiBus.release(SPI_CLIENT_UPLOAD);
     if (written != len)
     {
         Serial.printf("[Upload] Write error: wrote %u/%u\n", written, len);
@@ -46,16 +82,29 @@ bool UploadManager::writeChunk(const uint8_t *data, size_t len)
 
 void UploadManager::closeFile()
 {
+    spiBus.acquire(SPI_CLIENT_UPLOAD);
     if (_fileOpen)
     {
         _file.close();
         _fileOpen = false;
     }
+    if (_packOpen)
+    {
+        if (!_packWriter.finish())
+        {
+            Serial.printf("[Upload] Incomplete frame in %s\n", _path);
+            _uploadError = true;
+        }
+        _packOpen = false;
+    }
+    spiBus.release(SPI_CLIENT_UPLOAD);
 }
 
 bool UploadManager::openOriginal(const char *path)
 {
+    spiBus.acquire(SPI_CLIENT_UPLOAD);
     _originalFile = SD.open(path, FILE_WRITE);
+    spiBus.release(SPI_CLIENT_UPLOAD);
     if (!_originalFile)
     {
         Serial.printf("[Upload] Cannot create original: %s\n", path);
@@ -71,7 +120,9 @@ bool UploadManager::writeOriginalChunk(const uint8_t *data, size_t len)
     if (!_origFileOpen || _uploadError)
         return false;
     _lastUploadMs = millis();
+    spiBus.acquire(SPI_CLIENT_UPLOAD);
     size_t written = _originalFile.write(data, len);
+    spiBus.release(SPI_CLIENT_UPLOAD);
     if (written != len)
     {
         Serial.printf("[Upload] Original write error: wrote %u/%u\n", written, len);
@@ -85,7 +136,9 @@ void UploadManager::closeOriginal()
 {
     if (_origFileOpen)
     {
+        spiBus.acquire(SPI_CLIENT_UPLOAD);
         _originalFile.close();
+        spiBus.release(SPI_CLIENT_UPLOAD);
         _origFileOpen = false;
     }
 }
@@ -4,16 +4,18 @@
 #include <Arduino.h>
 #include <SD.h>
 #include "config.h"
+#include "frame_pack.h"
 
 class UploadManager
 {
 public:
     bool isUploading() const { return _isUploading; }
-    bool isFileOpen() const { return _fileOpen; }
+    bool isFileOpen() const { return _fileOpen || _packOpen; }
 
     bool consumeError();
 
     bool openFile(const char *path);
+    bool openPackFrame(const char *packPath, int index);
     bool writeChunk(const uint8_t *data, size_t len);
     void closeFile();
 
@@ -31,12 +33,14 @@ public:
 private:
     File _file;
     File _originalFile;
+    PackFrameWriter _packWriter;
     char _path[64];
     volatile bool _isUploading = false;
     volatile bool _uploadError = false;
     volatile unsigned long _lastUploadMs = 0;
     volatile bool _fileOpen = false;
     volatile bool _origFileOpen = false;
+    volatile bool _packOpen = false;
 };
 
 extern UploadManager uploadManager;
@@ -604,14 +604,16 @@ const char INDEX_HTML[] PROGMEM = R"rawliteral(
                     return;
                 }
                 
-                // Scale frames if needed
+                // GIFs that already fit are decoded on the device straight from the original file.
+                // Anything larger is scaled here, with duplicate "hold" frames dropped.
+                const playOriginal = frames[0].width <= MAX_SIZE && frames[0].height <= MAX_SIZE;
                 updateProgress('Scaling frames...', 5);
-                const scaledFrames = scaleFrames(frames, MAX_SIZE);
+                const scaledFrames = playOriginal ? frames : mergeHoldFrames(scaleFrames(frames, MAX_SIZE));
                 
                 let gifName = file.name.replace(/\.gif$/i, '').replace(/[^a-zA-Z0-9_-]/g, '_');
                 if (gifName.length > MAX_NAME_LEN) gifName = gifName.substring(0, MAX_NAME_LEN);
                 
-                // Calculate average delay for defaultDelay
+                // Average delay is only the fallback; per-frame delays go in `delays`
                 const totalDelay = scaledFrames.reduce((sum, f) => sum + f.delay, 0);
                 const defaultDelay = Math.round(totalDelay / scaledFrames.length);
                 
@@ -625,7 +627,9 @@ const char INDEX_HTML[] PROGMEM = R"rawliteral(
                         frameCount: scaledFrames.length,
                         width: scaledFrames[0].width,
                         height: scaledFrames[0].height,
-                        defaultDelay: defaultDelay
+                        defaultDelay: defaultDelay,
+                        delays: scaledFrames.map(f => Math.min(Math.round(f.delay), 65535)),
+                        original: playOriginal
                     })
                 });
                 
@@ -634,12 +638,40 @@ const char INDEX_HTML[] PROGMEM = R"rawliteral(
                 }
                 
                 // Upload frames sequentially (ESP32 SD card can't handle parallel writes)
-                const totalFrames = scaledFrames.length;
+                const totalFrames = playOriginal ? 0 : scaledFrames.length;
                 const MAX_RETRIES = 3;
                 
+                let prevPixels = null;
                 for (let i = 0; i < totalFrames; i++) {
                     const frame = scaledFrames[i];
-                    const bmpData = createBmp(frame.imageData, frame.width, frame.height);
+                    const pixels = toRgb565(frame.imageData);
+                    
+                    // Upload the smallest of raw / RLE / palette / delta; frame 0 is never a delta. Raw wins ties
+                    // unless the saving is worth a 25% margin, since it decodes fastest.
+                    let frameData = null;
+                    let frameName = `${i}.bmp`;
+                    let best = pixels.length * 2 * 3 / 4;
+                    const rle = encodeRle(pixels);
+                    if (rle.byteLength < best) {
+                        frameData = rle;
+                        frameName = `${i}.rle`;
+                        best = rle.byteLength;
+                    }
+                    const pal = encodePal8(pixels);
+                    if (pal && pal.byteLength < best) {
+                        frameData = pal;
+                        frameName = `${i}.pal`;
+                        best = pal.byteLength;
+                    }
+                    if (prevPixels) {
+                        const delta = encodeDelta(prevPixels, pixels, frame.imageData.width, frame.imageData.height);
+                        if (delta.byteLength < best) {
+                            frameData = delta;
+                            frameName = `${i}.delta`;
+                        }
+                    }
+                    if (!frameData) frameData = createBmp(frame.imageData, frame.width, frame.height);
+                    prevPixels = pixels;
                     
                     let uploaded = false;
                     for (let attempt = 0; attempt < MAX_RETRIES && !uploaded; attempt++) {
@@ -651,7 +683,7 @@ const char INDEX_HTML[] PROGMEM = R"rawliteral(
                             }
                             
                             const formData = new FormData();
-                            formData.append('frame', new Blob([bmpData], { type: 'image/bmp' }), `${i}.bmp`);
+                            formData.append('frame', new Blob([frameData], { type: 'application/octet-stream' }), frameName);
                             
                             const res = await fetch(`/api/gif/${gifName}/frame/${i}`, {
                                 method: 'POST',
@@ -693,7 +725,12 @@ const char INDEX_HTML[] PROGMEM = R"rawliteral(
                         console.warn(`Original upload attempt ${attempt + 1} failed:`, e.message);
                     }
                 }
-                if (!origUploaded) {
+                if (!origUploaded && playOriginal) {
+                    // The original is all the device has to play
+                    await fetch('/api/abort-upload', { method: 'POST' }).catch(() => {});
+                    await fetch(`/api/gif/${gifName}`, { method: 'DELETE' }).catch(() => {});
+                    throw new Error(`Upload failed after ${MAX_RETRIES} retries`);
+                } else if (!origUploaded) {
                     // Frames uploaded fine but original failed — not critical, just warn
                     console.warn('Could not upload original GIF file for preview');
                     await fetch('/api/abort-upload', { method: 'POST' }).catch(() => {});
@@ -782,6 +819,150 @@ const char INDEX_HTML[] PROGMEM = R"rawliteral(
             });
         }
         
+        function toRgb565(imageData) {
+            const src = imageData.data;
+            const out = new Uint16Array(imageData.width * imageData.height);
+            for (let i = 0; i < out.length; i++) {
+                const r = src[i * 4], g = src[i * 4 + 1], b = src[i * 4 + 2];
+                out[i] = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+            }
+            return out;
+        }
+        
+        // "HD" delta record: uint16 rectCount, then per rect x,y,w,h (uint8) + RGB565 pixels.
+        // One bounding rect per 16-row band keeps the rect count small for sprite motion.
+        function encodeDelta(prev, cur, width, height) {
+            const BAND = 16;
+            const rects = [];
+            for (let y0 = 0; y0 < height; y0 += BAND) {
+                let minX = width, maxX = -1, minY = height, maxY = -1;
+                for (let y = y0; y < Math.min(y0 + BAND, height); y++) {
+                    for (let x = 0; x < width; x++) {
+                        const i = y * width + x;
+                        if (prev[i] !== cur[i]) {
+                            if (x < minX) minX = x;
+                            if (x > maxX) maxX = x;
+                            if (y < minY) minY = y;
+                            maxY = y;
+                        }
+                    }
+                }
+                if (maxX >= 0) rects.push({ x: minX, y: minY, w: maxX - minX + 1, h: maxY - minY + 1 });
+            }
+            
+            const size = 4 + rects.reduce((sum, r) => sum + 4 + r.w * r.h * 2, 0);
+            const buffer = new ArrayBuffer(size);
+            const view = new DataView(buffer);
+            view.setUint8(0, 0x48); // 'H'
+            view.setUint8(1, 0x44); // 'D'
+            view.setUint16(2, rects.length, true);
+            let offset = 4;
+            for (const r of rects) {
+                view.setUint8(offset, r.x);
+                view.setUint8(offset + 1, r.y);
+                view.setUint8(offset + 2, r.w);
+                view.setUint8(offset + 3, r.h);
+                offset += 4;
+                for (let y = r.y; y < r.y + r.h; y++) {
+                    for (let x = r.x; x < r.x + r.w; x++) {
+                        view.setUint16(offset, cur[y * width + x], true);
+                        offset += 2;
+                    }
+                }
+            }
+            return buffer;
+        }
+        
+        // "HP" palette record: uint16 count, RGB565 palette, one index byte per pixel.
+        // Returns null when the frame has more than 256 distinct colors.
+        function encodePal8(pixels) {
+            const lookup = new Map();
+            const palette = [];
+            const indices = new Uint8Array(pixels.length);
+            for (let i = 0; i < pixels.length; i++) {
+                let idx = lookup.get(pixels[i]);
+                if (idx === undefined) {
+                    if (palette.length === 256) return null;
+                    idx = palette.length;
+                    palette.push(pixels[i]);
+                    lookup.set(pixels[i], idx);
+                }
+                indices[i] = idx;
+            }
+            
+            const buffer = new ArrayBuffer(4 + palette.length * 2 + indices.length);
+            const view = new DataView(buffer);
+            view.setUint8(0, 0x48); // 'H'
+            view.setUint8(1, 0x50); // 'P'
+            view.setUint16(2, palette.length, true);
+            palette.forEach((c, k) => view.setUint16(4 + k * 2, c, true));
+            new Uint8Array(buffer, 4 + palette.length * 2).set(indices);
+            return buffer;
+        }
+        
+        // "HR" RLE record over the whole frame in raster order. Control byte c covers
+        // (c & 0x7F) + 1 pixels: bit 7 set = one repeated pixel, clear = literal pixels.
+        function encodeRle(pixels) {
+            const out = new Uint8Array(2 + pixels.length * 2 + Math.ceil(pixels.length / 128) + 2);
+            out[0] = 0x48; // 'H'
+            out[1] = 0x52; // 'R'
+            let o = 2;
+            let i = 0;
+            let litStart = -1;
+            const flushLiteral = (end) => {
+                while (litStart >= 0 && litStart < end) {
+                    const n = Math.min(128, end - litStart);
+                    out[o++] = n - 1;
+                    for (let k = litStart; k < litStart + n; k++) {
+                        out[o++] = pixels[k] & 0xFF;
+                        out[o++] = pixels[k] >> 8;
+                    }
+                    litStart += n;
+                }
+                litStart = -1;
+            };
+            while (i < pixels.length) {
+                let run = 1;
+                while (i + run < pixels.length && run < 128 && pixels[i + run] === pixels[i]) run++;
+                if (run >= 3 || (run === 2 && litStart < 0)) {
+                    flushLiteral(i);
+                    out[o++] = 0x80 | (run - 1);
+                    out[o++] = pixels[i] & 0xFF;
+                    out[o++] = pixels[i] >> 8;
+                    i += run;
+                } else {
+                    if (litStart < 0) litStart = i;
+                    i += run;
+                }
+            }
+            flushLiteral(pixels.length);
+            return out.slice(0, o).buffer;
+        }
+        
+        // Collapse runs of identical frames into one frame holding the summed delay
+        function mergeHoldFrames(frames) {
+            const merged = [];
+            for (const frame of frames) {
+                const prev = merged[merged.length - 1];
+                if (prev && sameImage(prev.imageData, frame.imageData)) {
+                    prev.delay += frame.delay;
+                } else {
+                    merged.push({ ...frame });
+                }
+            }
+            return merged;
+        }
+        
+        function sameImage(a, b) {
+            if (a.width !== b.width || a.height !== b.height) return false;
+            const x = new Uint32Array(a.data.buffer);
+            const y = new Uint32Array(b.data.buffer);
+            for (let i = 0; i < x.length; i++) {
+                if (x[i] !== y[i]) return false;
+            }
+            return true;
+        }
+        
         // Parse GIF using browser's native decoding via ImageDecoder API or fallback
         async function parseGif(data) {
             // Try ImageDecoder API (Chrome/Edge) with proper frame composition
@@ -4,6 +4,10 @@
 #include "gif_routes.h"
 #include "np_routes.h"
 #include "app.h"
+#include "frame_loader.h"
+#include "gif_manager.h"
+#include "gif_app.h"
+#include "perf_stats.h"
 #include <WiFi.h>
 #include <SD.h>
 #include <AsyncJson.h>
@@ -158,6 +162,7 @@ void HoloWebServer::setupRoutes()
             Serial.printf("[WiFi] Saved config: SSID=\"%s\"\n", ssid);
             request->send(200, "application/json", "{\"success\":true,\"message\":\"WiFi config saved. Rebooting...\"}");
 
+            gifManager.flush();
             delay(500);
             ESP.restart();
         });
@@ -204,6 +209,30 @@ void HoloWebServer::setupRoutes()
         });
     _server.addHandler(modeHandler);
 
+    // Timing histograms; DELETE starts a new measurement window
+    _server.on("/api/stats", HTTP_GET, [](AsyncWebServerRequest *request)
+               {
+                   JsonDocument doc;
+                   perfStats.toJson(doc.to<JsonObject>());
+                   doc["freeHeap"] = ESP.getFreeHeap();
+                   doc["underruns"] = frameLoader.underruns();
+                   const FrameScheduler &sched = gifApp.scheduler();
+                   doc["presentedFrames"] = sched.presentedFrames();
+                   doc["lateFrames"] = sched.lateFrames();
+                   doc["droppedFrames"] = sched.droppedFrames();
+                   doc["libraryChanges"] = gifManager.saveRequests();
+                   doc["libraryWrites"] = gifManager.saveWrites();
+
+                   String response;
+                   serializeJson(doc, response);
+                   request->send(200, "application/json", response); });
+
+    _server.on("/api/stats", HTTP_DELETE, [](AsyncWebServerRequest *request)
+               {
+                   perfStats.reset();
+                   gifApp.scheduler().resetStats();
+                   request->send(200, "application/json", "{\"success\":true}"); });
+
     _server.onNotFound([](AsyncWebServerRequest *request)
                        { request->send(404, "text/plain", "Not Found"); });
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "wifi_manager.h"
 #include "display.h"
 #include "config.h"
+#include "perf_stats.h"
 #include <WiFi.h>
 #include <SD.h>
 #include <ArduinoJson.h>
@@ -46,10 +47,15 @@ bool WiFiManager::loadConfig(String &ssid, String &password)
     return true;
 }
 
+// Starts the station; with _wait set, also blocks until it connects or times out
 bool WiFiManager::connectStation(const String &ssid, const String &password)
 {
     WiFi.mode(WIFI_STA);
     WiFi.begin(ssid.c_str(), password.c_str());
+    _ssid = ssid;
+    _connecting = true;
+    if (!_wait)
+        return true;
 
     int attempts = 0;
     int maxAttempts = WIFI_CONNECT_TIMEOUT * 2;
@@ -62,16 +68,29 @@ bool WiFiManager::connectStation(const String &ssid, const String &password)
 
     if (WiFi.status() == WL_CONNECTED)
     {
-        Serial.printf("\n[WiFi] Connected: %s\n", WiFi.localIP().toString().c_str());
-        configTime(NTP_GMT_OFFSET, NTP_DAYLIGHT_OFFSET, NTP_SERVER);
+        onConnected();
         return true;
     }
 
-    Serial.printf("\n[WiFi] Failed to connect to \"%s\"\n", ssid.c_str());
-    WiFi.disconnect(true);
+    onConnectFailed();
     return false;
 }
 
+void WiFiManager::onConnected()
+{
+    _connecting = false;
+    Serial.printf("\n[WiFi] Connected: %s\n", WiFi.localIP().toString().c_str());
+    configTime(NTP_GMT_OFFSET, NTP_DAYLIGHT_OFFSET, NTP_SERVER);
+    perfStats.bootPhase("wifi", _startMs);
+}
+
+void WiFiManager::onConnectFailed()
+{
+    _connecting = false;
+    Serial.printf("\n[WiFi] Failed to connect to \"%s\"\n", _ssid.c_str());
+    WiFi.disconnect(true);
+}
+
 void WiFiManager::startAccessPoint()
 {
     Serial.println("[WiFi] Starting AP mode");
@@ -79,6 +98,11 @@ void WiFiManager::startAccessPoint()
     WiFi.softAP(AP_SSID, AP_PASSWORD);
     Serial.printf("[WiFi] AP: %s / %s\n", AP_SSID, AP_PASSWORD);
     Serial.printf("[WiFi] IP: %s\n", WiFi.softAPIP().toString().c_str());
+    perfStats.bootPhase("wifi (AP)", _startMs);
+
+    // In the background the app owns the panel; the status strip shows "AP"
+    if (!_wait)
+        return;
 
     display.clear();
     display.showMessage("WiFi Setup", 10, 30);
@@ -86,14 +110,32 @@ void WiFiManager::startAccessPoint()
     display.showMessage(WiFi.softAPIP().toString(), 10, 70);
 }
 
-void WiFiManager::begin()
+void WiFiManager::begin(bool wait)
 {
+    _wait = wait;
+    _startMs = millis();
     String ssid, password;
     if (loadConfig(ssid, password) && connectStation(ssid, password))
         return;
     startAccessPoint();
 }
 
+void WiFiManager::loop()
+{
+    if (!_connecting)
+        return;
+
+    if (WiFi.status() == WL_CONNECTED)
+    {
+        onConnected();
+    }
+    else if (millis() - _startMs >= WIFI_CONNECT_TIMEOUT * 1000UL)
+    {
+        onConnectFailed();
+        startAccessPoint();
+    }
+}
+
 bool WiFiManager::isConnected() const
 {
     return WiFi.status() == WL_CONNECTED;
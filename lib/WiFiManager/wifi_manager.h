@@ -6,12 +6,24 @@
 class WiFiManager
 {
 public:
-    void begin();
+    // wait = false returns as soon as the station is started; loop() then
+    // finishes connecting, or falls back to the access point after
+    // WIFI_CONNECT_TIMEOUT without drawing over the running app
+    void begin(bool wait = true);
+    void loop();
     bool isConnected() const;
+    bool isConnecting() const { return _connecting; }
 
 private:
+    bool _connecting = false;
+    bool _wait = true;
+    unsigned long _startMs = 0;
+    String _ssid;
+
     bool loadConfig(String &ssid, String &password);
     bool connectStation(const String &ssid, const String &password);
+    void onConnected();
+    void onConnectFailed();
     void startAccessPoint();
 };
 
@@ -4,8 +4,14 @@
 
 #include "config.h"
 #include "display.h"
+#include "status_strip.h"
+#include "spi_bus.h"
+#include "glyph_text.h"
+#include "pixel_kernels.h"
+#include "perf_stats.h"
 #include "mpu.h"
 #include "gif_manager.h"
+#include "frame_loader.h"
 #include "web_server.h"
 #include "wifi_manager.h"
 #include "app.h"
@@ -21,21 +27,41 @@ int currentAppIndex = 0;
 
 void switchApp(int newIndex);
 
+// Boot timeline (see PerfStats::bootPhase). With FAST_BOOT the app starts right
+// after the library index is read; WiFi, MPU calibration and a missing-index
+// scan record their own phases when they finish in the background.
 void setup()
 {
   Serial.begin(115200);
-  delay(200);
+  if (!FAST_BOOT)
+    delay(200);
   Serial.println("[Main] Starting");
 
   SPI.begin(PIN_SCK, PIN_MISO, PIN_MOSI);
   SPI.setFrequency(SPI_FREQUENCY);
 
+  perfStats.begin();
+  perfStats.bootPhase("reset", 0);
+  uint32_t phaseMs = millis();
+  spiBus.begin();
+  glyphText.begin();
   display.begin();
+  statusStrip.begin();
+  perfStats.bootPhase("display", phaseMs);
+  if (TEXT_BENCH_STRINGS > 0)
+  {
+    glyphText.benchmark(display.getBackCanvas());
+    display.clearBackBuffer();
+  }
+  pxBenchmark();
   display.clear();
   display.showMessage("Initializing...");
   Serial.println("[Main] Display initialized");
 
-  if (!gifManager.begin())
+  phaseMs = millis();
+  gifManager.setOnScanDone([]()
+                           { gifApp.notifyGifChange(); });
+  if (!gifManager.begin(FAST_BOOT))
   {
     display.showMessage("SD Card Error!");
     Serial.println("[Main] SD card failed!");
@@ -43,18 +69,32 @@ void setup()
       delay(100);
   }
   Serial.println("[Main] SD card initialized");
+  perfStats.bootPhase("library", phaseMs);
+  gifManager.benchmark();
 
-  display.clear();
-  display.showMessage("Connecting WiFi...");
-  wifiManager.begin();
+  // Starting the station also brings up the network stack the web server binds to
+  if (!FAST_BOOT)
+  {
+    display.clear();
+    display.showMessage("Connecting WiFi...");
+  }
+  wifiManager.begin(!FAST_BOOT);
 
   mpu.begin();
-  delay(50);
-  display.clear();
-  display.showMessage("Calibrating...");
-  mpu.calibrate(300);
-  Serial.println("[Main] MPU calibrated");
+  if (FAST_BOOT)
+  {
+    mpu.startCalibration();
+  }
+  else
+  {
+    delay(50);
+    display.clear();
+    display.showMessage("Calibrating...");
+    mpu.calibrate();
+    Serial.println("[Main] MPU calibrated");
+  }
 
+  phaseMs = millis();
   webServer.setOnGifChange([]()
                            { gifApp.notifyGifChange(); });
   webServer.setOnModeChange([](int index)
@@ -64,15 +104,23 @@ void setup()
   webServer.setAppInfo(apps, &APP_COUNT, &currentAppIndex);
   webServer.begin();
 
-  display.showIP(webServer.getLocalIP());
-  Serial.printf("[Main] Web UI: http://%s\n", webServer.getLocalIP());
-  delay(3000);
+  // Size the decoded-frame pool once, after WiFi and the web server took their share
+  frameLoader.begin();
+  perfStats.bootPhase("web + pool", phaseMs);
+
+  if (!FAST_BOOT)
+  {
+    display.showIP(webServer.getLocalIP());
+    Serial.printf("[Main] Web UI: http://%s\n", webServer.getLocalIP());
+    delay(3000);
+  }
 
   display.clear();
 
   currentAppIndex = 0;
+  statusStrip.setTitle(apps[currentAppIndex]->name());
   apps[currentAppIndex]->onEnter();
-  apps[currentAppIndex]->triggerOverlay();
+  perfStats.bootPhase("setup", 0);
 
   Serial.printf("[Main] Ready! Running %s app. %d GIFs found.\n",
                 apps[currentAppIndex]->name(), gifManager.getGifCount());
@@ -80,6 +128,16 @@ void setup()
 
 void loop()
 {
+  static bool firstFrame = false;
+  if (!firstFrame && display.presentCount() > 0)
+  {
+    firstFrame = true;
+    perfStats.bootPhase("first frame", 0);
+  }
+
+  wifiManager.loop();
+  mpu.calibrateStep();
+
   static unsigned long lastMpuCheck = 0;
   int tiltDir = 0;
   if (millis() - lastMpuCheck >= 50)
@@ -89,14 +147,14 @@ void loop()
   }
 
   if (tiltDir != 0)
-  {
-    if (apps[currentAppIndex]->onTilt(tiltDir))
-      apps[currentAppIndex]->triggerOverlay();
-  }
+    apps[currentAppIndex]->onTilt(tiltDir);
 
-  apps[currentAppIndex]->updateOverlay();
   webServer.checkUploadTimeout();
+  gifManager.loop();
+  uint32_t appStart = PerfStats::now();
   apps[currentAppIndex]->loop();
+  perfStats.record(PERF_APP_UPDATE, appStart);
+  statusStrip.loop();
 }
 
 void switchApp(int newIndex)
@@ -106,7 +164,8 @@ void switchApp(int newIndex)
 
   apps[currentAppIndex]->onExit();
   currentAppIndex = newIndex;
+  statusStrip.setTitle(apps[currentAppIndex]->name());
+  statusStrip.setPosition(0, 0);
   apps[currentAppIndex]->onEnter();
-  apps[currentAppIndex]->triggerOverlay();
   Serial.printf("[Main] Switched to %s app\n", apps[currentAppIndex]->name());
 }